@@ -30,17 +30,20 @@
 //   - adjacency matrics
 //   - adjacency lists
 //   - adjacency multilists     // not in use
+//   - compressed sparse row (CSR), a frozen copy of the adjacency lists
 //
 // Graph Traversals:
 //   - Depth First Search
 //   - Breadth First Search
+//   - Parallel Direction Optimizing BFS (top-down and bottom-up)
 //
 // Shortest Path
 //   + single pair: from one node to another
 //     - Shortest Path BFS
 //   + single source: from one node to all other nodes
-//     - Dijkstra's Algorithm
+//     - Dijkstra's Algorithm (indexed min-heap, see heap.cpp)
 //     - Bellman Ford Algorithm
+//     - Shortest Path Faster Algorithm (SPFA, queue based Bellman Ford)
 //   - signle destination: from all nodes to one node
 //   - all pairs: between every pairs
 //
@@ -60,7 +63,7 @@
 //     a graph havin a spinning tree is connected.
 //   + algorithms to find the minimum spinning tree of a graph:
 //     - Prim Algorithm
-//     - Kruskal Algorithm
+//     - Kruskal Algorithm (disjoint set)
 //
 // Detect Cycle Methods
 //     - DFS
@@ -71,7 +74,9 @@
 // 
 // Graph Implementation
 //   - the vertex is unique, indexed during the creation of the graph.
+//   - a hash map finds the index of a vertex in O(1).
 //   - the adjacent list is in the order of the source vertex indexes.
+//   - every edge keeps the index of its destination vertex.
 //
 
 #include <iostream>
@@ -84,6 +89,16 @@
 #include <algorithm>
 #include <climits>
 #include <cmath>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+
+#define HEAP_LIBRARY    // HeapTree without its testing driver
+#include "heap.cpp"
 
 using namespace std;
 
@@ -99,9 +114,11 @@ struct Edge {
     Vertex  src;        // the source vertex of an edge in directed graph
     Vertex  dst;        // the destination vertex of an edge in directed graph
     Weight  weight;     // the cost from the source vertex to the destination vertext
+    int     dst_index;  // the index of the destination vertex, -1 if unknown
 
-    Edge(Vertex s, Vertex d) : src(s), dst(d), weight(1) { }
-    Edge(Vertex s, Vertex d, Weight w) : src(s), dst(d), weight(w) { }
+    Edge(Vertex s, Vertex d) : src(s), dst(d), weight(1), dst_index(-1) { }
+    Edge(Vertex s, Vertex d, Weight w) : src(s), dst(d), weight(w), dst_index(-1) { }
+    Edge(Vertex s, Vertex d, Weight w, int di) : src(s), dst(d), weight(w), dst_index(di) { }
 
     bool equal_directed(Edge e) { return this->src == e.src && this->dst == e.dst; } 
     bool equal_undirected(Edge e) { return (this->src == e.src && this->dst == e.dst) ||
@@ -119,6 +136,7 @@ class Graph {
     bool  directed;             // directed graph, false by default
     bool  weighted;             // edges have weights (costs)
     vector<Vertex>  vertices;   // sorted dynamic list (vector)
+    unordered_map<Vertex, int>  index_map;  // vertex -> index in vertices
 
 public:
     vector<list<Edge>> edge_lists;    // adjacent_list, unsorted, represents the graph
@@ -149,8 +167,13 @@ public:
     void  print_graph();
 
     int   algorithm_shortest_path(Vertex s, Vertex d, vector<Vertex>& path);
-    void  algorithm_bellman_ford(Vertex start, int *distances);
+    int   algorithm_dijkstra(Vertex s, Vertex d, vector<int>& distances, vector<int>& previous);
+    void  algorithm_dijkstra(Vertex s, vector<int>& distances, vector<int>& previous);
+    void  get_path(Vertex d, const vector<int>& previous, vector<Vertex>& path);
+    bool  algorithm_bellman_ford(Vertex start, int *distances);
+    bool  algorithm_spfa(Vertex start, int *distances);
     void  algorithm_mst_prim(Vertex v0, vector<Edge>& mst);
+    void  algorithm_mst_kruskal(vector<Edge>& mst);
     void  topological_sort(vector<Vertex>& topo_sort);
     bool  detect_cycle_dfs(int vi, int pi, vector<int>& visited);
 };
@@ -158,21 +181,81 @@ public:
 #define COST_MAX   (UINT_MAX >> 1)  // avoid overflow
 #define NOT_VERTEX  '*'             // invalid vertex
 
+/* a fork-join thread pool for the level synchronous algorithms.
+ * + the worker threads are created once and wait for the tasks.
+ * + run() gives the same task to every worker with the worker id
+ *   (0 .. size() - 1), and returns when all the workers finish it.
+ */
+class ThreadPool {
+    vector<thread>  workers;
+    mutex           pool_lock;
+    condition_variable  task_ready;
+    condition_variable  task_done;
+    function<void (int)> task;
+    unsigned long   generation;     // number of the tasks given
+    int             running;        // number of the workers on the task
+    bool            stopping;
+
+    void  worker_loop(int id);
+public:
+    ThreadPool(int n);
+    ~ThreadPool();
+
+    int   size() { return workers.size(); }
+    void  run(function<void (int)> f);
+};
+
+/* a frozen compressed sparse row (CSR) form of a graph.
+ * + built from a Graph once all the vertices and edges are added,
+ *   it cannot be changed afterward.
+ * + the edges of the vertex (i) are at [offsets[i], offsets[i+1])
+ *   of targets[] and weights[].
+ * + the destinations are stored as vertex indexes, so the algorithms
+ *   walk the contiguous arrays without any lookup or pointer chasing.
+ */
+class GraphCSR {
+    bool  directed;             // same as the source graph
+    bool  weighted;             // same as the source graph
+    vector<Vertex>  vertices;   // same order (indexes) as the source graph
+    unordered_map<Vertex, int>  index_map;  // vertex -> index in vertices
+
+public:
+    vector<int>     offsets;    // number_vertices() + 1 entries
+    vector<int>     targets;    // destination vertex indexes
+    vector<Weight>  weights;    // edge weights, parallel to targets[]
+    vector<int>     in_offsets; // incoming edges of the directed graph,
+    vector<int>     in_sources; // built by build_incoming() when needed
+
+    GraphCSR(Graph& g);
+    void  build_incoming();
+
+    bool  is_directed() { return directed; }
+    bool  is_weighted() { return weighted; }
+    int   number_vertices() { return vertices.size(); }
+    int   number_edges() { return is_directed() ? targets.size() : targets.size() >> 1; }
+
+    Vertex get_vertex(int index);
+    int    get_index(Vertex v);
+
+    int   algorithm_shortest_path(Vertex s, Vertex d, vector<Vertex>& path);
+    bool  algorithm_bellman_ford(Vertex start, int *distances);
+    bool  algorithm_parallel_bellman_ford(Vertex start, ThreadPool& pool, int *distances);
+    void  algorithm_mst_prim(Vertex v0, vector<Edge>& mst);
+    void  topological_sort(vector<Vertex>& topo_sort);
+    bool  detect_cycle_dfs(int vi, int pi, vector<int>& visited);
+    void  algorithm_bfs(Vertex s, vector<int>& depths, vector<int>& parents);
+    void  algorithm_parallel_bfs(Vertex s, ThreadPool& pool, vector<int>& depths, vector<int>& parents);
+};
+
 /**********************************************************************
  * get_index()
- * return the index (position) of the vertex
- * improve: 
- *   define a vertex structure to include its index, maybe label too
+ * return the index (position) of the vertex, -1 if not found.
+ * the index is looked up in the hash map, O(1) on average.
  */
 int Graph::get_index(Vertex v)
 {
-    int nv = number_vertices();
-    for (int i = 0; i < nv; ++i) {
-        if (vertices[i] == v) {
-            return i;
-        }
-    }
-    return -1;
+    auto it = index_map.find(v);
+    return it == index_map.end() ? -1 : it->second;
 }
 /**********************************************************************
  * get_vertex()
@@ -187,22 +270,46 @@ Vertex Graph::get_vertex(int index)
 }
 /**********************************************************************
  * add_vertex()
- * append the vertex to the vertices list (vector).
- * return the index of the vertex.
+ * append the vertex to the vertices list (vector), and an empty
+ * adjacent list for it.
+ * return the index of the vertex, or the existing index if the
+ * vertex was added before.
  */
 int Graph::add_vertex(Vertex v)
 {
-    vertices.push_back(v);
-    return vertices.size() - 1;
+    auto it = index_map.emplace(v, vertices.size());
+    if (it.second) {
+        vertices.push_back(v);
+        edge_lists.emplace_back();
+    }
+    return it.first->second;
 }
 /**********************************************************************
  * delete_vertex()
- * delete the vertex, but not the edges extending to/from it
+ * delete the vertex and the edges extending to/from it.
+ * - the vertices after it move forward by one, so their indexes in
+ *   the hash map and in the edges are decreased.
+ * time complexity: O(V + E)
  */
 void Graph::delete_vertex(int index)
 {
-    if (index >= 0 && index < vertices.size()) {
-        vertices.erase(vertices.begin() + index);
+    if (index < 0 || index >= (int)vertices.size()) {
+        return;
+    }
+    index_map.erase(vertices[index]);
+    vertices.erase(vertices.begin() + index);
+    edge_lists.erase(edge_lists.begin() + index);
+
+    for (int i = index; i < (int)vertices.size(); ++i) {
+        index_map[vertices[i]] = i;
+    }
+    for (auto& elist : edge_lists) {
+        elist.remove_if([index](const Edge& e) { return e.dst_index == index; });
+        for (Edge& e : elist) {
+            if (e.dst_index > index) {
+                e.dst_index--;
+            }
+        }
     }
 }
 /**********************************************************************
@@ -230,7 +337,7 @@ void Graph::print_vertices()
 int Graph::number_edges()
 {
     int num = 0;
-    for (auto elist : edge_lists) {
+    for (auto& elist : edge_lists) {
         num += elist.size();
     }
     return is_directed() ? num : num >> 1;
@@ -247,34 +354,18 @@ bool Graph::equal_edge(Edge e1, Edge e2)
 /**********************************************************************
  * add_edge()
  * - every edge appends to the adjacent list of the source vertex.
- * - an empty list is added for destination vertex if not found.
+ * - the source and destination vertices are added if not found.
  * - also add the edge to the adjacent list of the destination vertex 
  *   for undirected graph.
  */
 void Graph::add_edge(Vertex s, Vertex d, Weight w)
 {
-    if ( find_vertex(s) ) {
-        int src_index = get_index(s); 
-        edge_lists[src_index].emplace_back(s, d, w);
-    }
-    else {
-        int src_index = add_vertex(s);
-        list<Edge> elist;
-        elist.emplace_back(s,d, w);
-        edge_lists.insert(edge_lists.begin() + src_index, elist);
-    }
-    
-    if ( !find_vertex(d) ) {
-        int dst_index = add_vertex(d);
-        list<Edge> elist;
-        if ( !is_directed() ) {
-            elist.emplace_back(d, s, w);
-        }
-        edge_lists.insert(edge_lists.begin() + dst_index, elist);
-    }
-    else if ( !is_directed() ) {
-        int dst_index = get_index(d); 
-        edge_lists[dst_index].emplace_back(d, s, w);
+    int src_index = add_vertex(s);
+    int dst_index = add_vertex(d);
+
+    edge_lists[src_index].emplace_back(s, d, w, dst_index);
+    if ( !is_directed() ) {
+        edge_lists[dst_index].emplace_back(d, s, w, src_index);
     }
 }
 /**********************************************************************
@@ -285,6 +376,9 @@ void Graph::add_edge(Vertex s, Vertex d, Weight w)
 void Graph::delete_edge(Vertex s, Vertex d)
 {
     int si = get_index(s);
+    if (si < 0) {
+        return;
+    }
     for (Edge e : edge_lists[si]) {
         if (e.dst == d) {
             edge_lists[si].remove(e);
@@ -340,7 +434,7 @@ int Graph::algorithm_shortest_path(Vertex s, Vertex d, vector<Vertex>& path)
          Q.pop();
 
         for (Edge e : edge_lists[vi]) {
-            int di = get_index(e.dst);
+            int di = e.dst_index;
             if (distances[vi] + e.weight < distances[di]) {
                 distances[di] = distances[vi] + e.weight;
                 previous[di] = e.src;
@@ -374,13 +468,107 @@ int Graph::algorithm_shortest_path(Vertex s, Vertex d, vector<Vertex>& path)
     }
     return  distances[di];
 }
+/**********************************************************************
+ * Algorithm Dijkstra (indexed min-heap)
+ * + shortest path for single source, greedy algorithm.
+ * + the edge weights must not be negative.
+ * algorithm:
+ *   + push the source vertex with distance 0 into a min-heap.
+ *   + pop the vertex with the least distance, it is settled (final).
+ *   + relax the edges of the settled vertex, push the neighbor vertex,
+ *     or decrease its key when it is in the heap already, so every
+ *     vertex is in the heap at most once.
+ *   + stop when the heap is empty, or when the destination is settled
+ *     for a single pair query.
+ * + time complexity:  O((V + E) * log(V))
+ *   space complexity: O(V)
+ *
+ * input:
+ *   (Vertex)s - the start (source) vertex
+ *   (Vertex)d - the destination vertex, or NOT_VERTEX for all vertices
+ * output:
+ *   (vector<int>)distances - the shortest distances by vertex indexes,
+ *                            COST_MAX if not reached. the distances of
+ *                            the vertices not settled yet are upper bounds
+ *                            when stopped early at d.
+ *   (vector<int>)previous  - the index of the previous vertex on the
+ *                            shortest path (predecessor tree). it is the
+ *                            source itself for s, -1 if not reached.
+ * return:
+ *   the distance from s to d, COST_MAX if d is not reached.
+ */
+int Graph::algorithm_dijkstra(Vertex s, Vertex d, vector<int>& distances, vector<int>& previous)
+{
+    int nv = number_vertices();
+    distances.assign(nv, COST_MAX);
+    previous.assign(nv, -1);
+
+    int si = get_index(s);
+    int di = get_index(d);
+    if (si < 0) {
+        return COST_MAX;
+    }
+    distances[si] = 0;
+    previous[si] = si;
+
+    vector<bool> settled(nv, false);
+    IndexedHeap<int> Q(nv, MIN_HEAP, 4);
+    Q.push(si, 0);
+
+    while (Q.get_size() > 0) {
+        int vi = Q.pop();
+        settled[vi] = true;
+        if (vi == di) {
+            break;
+        }
+        for (Edge& e : edge_lists[vi]) {
+            int ti = e.dst_index;
+            if (!settled[ti] && distances[vi] + e.weight < distances[ti]) {
+                distances[ti] = distances[vi] + e.weight;
+                previous[ti] = vi;
+                Q.contains(ti) ? Q.decrease_key(ti, distances[ti]) : Q.push(ti, distances[ti]);
+            }
+        }
+    }
+    return di < 0 ? COST_MAX : distances[di];
+}
+/* Dijkstra from the vertex s to all other vertices
+ */
+void Graph::algorithm_dijkstra(Vertex s, vector<int>& distances, vector<int>& previous)
+{
+    algorithm_dijkstra(s, NOT_VERTEX, distances, previous);
+}
+/**********************************************************************
+ * get_path()
+ * walk the predecessor tree from the vertex d back to the source, which
+ * is its own predecessor. the path (vertices) is from the source to d,
+ * empty if d was not reached.
+ */
+void Graph::get_path(Vertex d, const vector<int>& previous, vector<Vertex>& path)
+{
+    int vi = get_index(d);
+    if (vi < 0 || vi >= (int)previous.size() || previous[vi] < 0) {
+        return;
+    }
+    path.push_back(vertices[vi]);
+    while (previous[vi] != vi) {
+        vi = previous[vi];
+        path.push_back(vertices[vi]);
+    }
+    reverse(path.begin(), path.end());
+}
 /**********************************************************************
  * Algorithm Bellman Ford: 
  * + sortest path for single source, dynamic programming
- * + relax on every edge for every vertex.
+ * + relax on every edge for every vertex, in up to V - 1 rounds.
+ *   a shortest path has at most V - 1 edges, every round makes the
+ *   distances final for the paths one edge longer.
  * - works for the negtive weights, can be used to check the cycles.
  * - different: go to the next vertex, not the neighbor vertex
- * - cannot break out when there is nothing changed for every vertex.
+ * - break out when there is nothing changed in a round.
+ * - a negative cycle is reachable from the start if an edge can still
+ *   be relaxed after V - 1 rounds.
+ * - an undirected edge with a negative weight is a negative cycle.
  * 
  * + time complexity:  best O(E), average O(VE), worst O(VE)
  *   space complexity: O(V)
@@ -388,11 +576,14 @@ int Graph::algorithm_shortest_path(Vertex s, Vertex d, vector<Vertex>& path)
  * 
  * input:
  *   (Vertex)start - the start (source) vertex
- * return:
+ * output:
  *   (int*)distances - the shortest distances to other vertices.
  *                     the caller must allocate the memory of ditances[]
+ * return:
+ *   false if there is a negative cycle reachable from start, the
+ *   distances are not the shortest then.
  */
-void Graph::algorithm_bellman_ford(Vertex start, int *distances)
+bool Graph::algorithm_bellman_ford(Vertex start, int *distances)
 {
     int nv = number_vertices();  
     for (int i = 0; i < nv; i++) {
@@ -400,19 +591,84 @@ void Graph::algorithm_bellman_ford(Vertex start, int *distances)
     }
 
     int s = get_index(start);
+    if (s < 0) {
+        return true;
+    }
     distances[s] = 0;
     
-    // relax all vertices
-    for (int i = 0; i < nv; ++i) {
-        int vi = (i + s) % nv;
-        for (Edge e : edge_lists[vi]) {
-            int si = get_index(e.src);      // vi == si
-            int di = get_index(e.dst);
-            if (distances[si] != COST_MAX && distances[si] + e.weight < distances[di]) {
-                distances[di] = distances[si] + e.weight;
+    // relax all vertices, one more round to check the negative cycle
+    for (int round = 0; round < nv; ++round) {
+        bool changed = false;
+        for (int i = 0; i < nv; ++i) {
+            int vi = (i + s) % nv;
+            if (distances[vi] == COST_MAX) {
+                continue;
             }
+            for (Edge& e : edge_lists[vi]) {
+                int di = e.dst_index;
+                if (distances[vi] + e.weight < distances[di]) {
+                    distances[di] = distances[vi] + e.weight;
+                    changed = true;
+                }
+            }
+        }
+        if (!changed) {
+            return true;
         }
-    }  
+    }
+    return false;
+}
+/**********************************************************************
+ * Shortest Path Faster Algorithm (SPFA)
+ * + the queue based Bellman Ford, only relax the edges of the vertices
+ *   whose distances were changed.
+ * + a vertex is put into the queue when its distance becomes shorter,
+ *   and it is not in the queue yet.
+ * + a negative cycle is found when a vertex is put into the queue V
+ *   times, its path would have more than V - 1 edges.
+ * + time complexity:  average O(E), worst O(VE)
+ *   space complexity: O(V)
+ * input/output/return: the same as algorithm_bellman_ford().
+ */
+bool Graph::algorithm_spfa(Vertex start, int *distances)
+{
+    int nv = number_vertices();
+    for (int i = 0; i < nv; i++) {
+        distances[i] = COST_MAX;
+    }
+
+    int s = get_index(start);
+    if (s < 0) {
+        return true;
+    }
+    distances[s] = 0;
+
+    vector<bool> in_queue(nv, false);
+    vector<int>  count(nv, 0);      // times put into the queue
+    queue<int> Q;
+    Q.push(s);
+    in_queue[s] = true;
+    count[s] = 1;
+
+    while (!Q.empty()) {
+        int vi = Q.front();
+        Q.pop();
+        in_queue[vi] = false;
+        for (Edge& e : edge_lists[vi]) {
+            int di = e.dst_index;
+            if (distances[vi] + e.weight < distances[di]) {
+                distances[di] = distances[vi] + e.weight;
+                if (!in_queue[di]) {
+                    if (++count[di] >= nv) {
+                        return false;
+                    }
+                    Q.push(di);
+                    in_queue[di] = true;
+                }
+            }
+        }
+    }
+    return true;
 }
 /**********************************************************************
  * Kahn's Topological Sorting
@@ -434,7 +690,7 @@ void Graph::topological_sort(vector<Vertex>& topo_sort)
     vector<int> indegrees(nv, 0);
     for (int i = 0; i < nv; i++) { 
         for (Edge e : edge_lists[i]) { 
-            int di = get_index(e.dst);
+            int di = e.dst_index;
             indegrees[di]++;
         }
     }
@@ -453,7 +709,7 @@ void Graph::topological_sort(vector<Vertex>& topo_sort)
         Vertex v = get_vertex(i);
         topo_sort.push_back(v);
         for (auto e : edge_lists[i]) {
-            int di = get_index(e.dst);
+            int di = e.dst_index;
             indegrees[di]--;
             if (indegrees[di] == 0) {
                 no_incoming.push(di);
@@ -464,54 +720,153 @@ void Graph::topological_sort(vector<Vertex>& topo_sort)
 /**********************************************************************
  * Prim's Minimum Spanning Tree (Greedy Algorithm)
  * Algorithm:
- *   1. remove the self-loops and parallel edges
- *   2. choose a node as the root node
- *   3. select the outgoing edge with less weight
- *   4. 
+ *   1. the self-loops and parallel edges are never selected.
+ *   2. choose a node as the root node, put it in a min-heap.
+ *   3. pop the vertex with the least connecting weight from the heap,
+ *      select it with the edge that connects it to the tree.
+ *   4. for every edge to an unselected vertex, push the vertex into the
+ *      heap, or decrease its weight if the edge is lighter.
+ *   5. repeat 3 and 4 until the heap is empty, then start another tree
+ *      from the next unselected vertex, so a disconnected graph gets
+ *      a minimum spanning forest.
+ * + time complexity:  O(E * log(V))
+ *   space complexity: O(V)
  */
 void Graph::algorithm_mst_prim(Vertex v0, vector<Edge>& mst)
 {
     int nv = number_vertices();
-    bool selected[nv] = { false };
+    int ri = get_index(v0);
+    if (ri < 0) {
+        return;
+    }
+
+    vector<bool> selected(nv, false);
+    vector<int>  link(nv, -1);          // the tree vertex that connects to
+    IndexedHeap<Weight> Q(nv);          // the connecting weights
 
-/*
-    // find the vertex having the minimum weight, should be done by min-heap
-    int min_vertex_si, min_vertex_di;
-    int min_weight = INT_MAX;
+    for (int i = 0; i < nv; ++i, ri = (ri + 1) % nv) {
+        if (selected[ri]) {
+            continue;
+        }
+        Q.push(ri, 0);
+        while (Q.get_size() > 0) {
+            int vi = Q.pop();
+            selected[vi] = true;
+            if (link[vi] >= 0) {
+                mst.emplace_back(vertices[link[vi]], vertices[vi], Q.get_key(vi), vi);
+            }
+            for (Edge& e : edge_lists[vi]) {
+                int ti = e.dst_index;
+                if (selected[ti]) {
+                    continue;
+                }
+                if ( !Q.contains(ti) ) {
+                    link[ti] = vi;
+                    Q.push(ti, e.weight);
+                }
+                else if (e.weight < Q.get_key(ti)) {
+                    link[ti] = vi;
+                    Q.decrease_key(ti, e.weight);
+                }
+            }
+        }
+    }
+}
+/**********************************************************************
+ * Disjoint Set (Union Find)
+ *   keeps a collection of non-overlapping sets of the elements 0..n-1,
+ *   every set is a tree, the root of the tree represents the set.
+ * + find(): return the root of the set that has the element, and point
+ *   the elements on the way to their grandparents (path halving).
+ * + unite(): merge two sets by linking the root of the lower tree
+ *   under the root of the higher tree (union by rank).
+ * + time complexity: O(alpha(n)) amortized per operation,
+ *   alpha is the inverse Ackermann function, less than 5 in practice.
+ * applications:
+ *   - Kruskal's minimum spanning tree
+ *   - detect cycles in undirected graphs
+ *   - connected components
+ */
+class DisjointSet {
+    vector<int>  parent;        // the parent of the element, itself for a root
+    vector<int>  rank;          // upper bound of the tree height of a root
+    int          num_sets;      // number of the disjoint sets
+public:
+    DisjointSet(int n) : parent(n), rank(n, 0), num_sets(n) {
+        for (int i = 0; i < n; ++i) { parent[i] = i; }
+    }
+
+    int   find(int x);
+    bool  unite(int x, int y);
+    bool  same_set(int x, int y) { return find(x) == find(y); }
+    int   number_sets() { return num_sets; }
+};
+
+int DisjointSet::find(int x)
+{
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+/* return false if x and y are already in the same set
+ */
+bool DisjointSet::unite(int x, int y)
+{
+    x = find(x);
+    y = find(y);
+    if (x == y) {
+        return false;
+    }
+    if (rank[x] < rank[y]) {
+        swap(x, y);
+    }
+    parent[y] = x;
+    if (rank[x] == rank[y]) {
+        rank[x]++;
+    }
+    --num_sets;
+    return true;
+}
+/**********************************************************************
+ * Kruskal's Minimum Spanning Tree (Greedy Algorithm)
+ * algorithm:
+ *   1. collect the edges, once for every pair of the undirected graph,
+ *      the directions of a directed graph are ignored.
+ *   2. sort the edges by their weights.
+ *   3. go through the sorted edges, take the edge when its vertices are
+ *      in different sets (trees), and unite the two sets.
+ *   4. stop when V - 1 edges are taken.
+ * + the result is a minimum spanning forest when the graph is not
+ *   connected, one tree for every connected component.
+ * + time complexity:  O(E * log(E))
+ *   space complexity: O(V + E)
+ */
+void Graph::algorithm_mst_kruskal(vector<Edge>& mst)
+{
+    int nv = number_vertices();
+
+    vector<Edge> edges;
     for (int vi = 0; vi < nv; ++vi) {
-        for (Edge e : edge_lists[vi]) {
-            if (e.weight < min_weight) {
-                min_weight = e.weight;
-                min_vertex_si = vi;
-                min_vertex_di = get_index(e.dst);
+        for (Edge& e : edge_lists[vi]) {
+            if (is_directed() || vi < e.dst_index) {
+                edges.push_back(e);
             }
         }
     }
-    Vertex v0 = get_vertex(min_vertex_si);
-    mst.push_back(v0);
-    visited[min_vertex_si] = true;
-    cout << "Min Vertex: " << char(v0) << " (" << min_vertex_si << ", " << min_vertex_di << ")" << endl;
-*/
-    int vi = get_index(v0);
-    selected[vi] = true;
-    vector<int> vertices; 
-    vertices.push_back(vi);
-    
-    for (int edge_count = 0; edge_count < nv - 1; ++edge_count) {
-        Edge min_edge(v0, NOT_VERTEX, INT_MAX);
-        for (int vi : vertices) {
-            for(Edge e : edge_lists[vi]) {
-                int di = get_index(e.dst);
-                if ( !selected[di] && e.weight < min_edge.weight) {
-                    min_edge = e;
-                }
+    stable_sort(edges.begin(), edges.end(),
+                [](const Edge& e1, const Edge& e2) { return e1.weight < e2.weight; });
+
+    DisjointSet trees(nv);
+    for (Edge& e : edges) {
+        if (trees.unite(get_index(e.src), e.dst_index)) {
+            mst.push_back(e);
+            if (trees.number_sets() == 1) {
+                break;
             }
         }
-        mst.push_back(min_edge);
-        vi = get_index(min_edge.dst);
-        vertices.push_back(vi);
-        selected[vi] = true;
-    }   
+    }
 }
 /**********************************************************************
  * Detect Cycle using DFS (or DFT)
@@ -528,7 +883,7 @@ bool Graph::detect_cycle_dfs(int vi, int pi, vector<int>& visited)
     visited[vi] = true;
     cout << vi << "(" << char(get_vertex(vi)) << "), ";
     for (Edge e : edge_lists[vi]) {
-        int di = get_index(e.dst);
+        int di = e.dst_index;
         if (!visited[di]) {
             return detect_cycle_dfs(di, vi, visited);
         }
@@ -540,6 +895,578 @@ bool Graph::detect_cycle_dfs(int vi, int pi, vector<int>& visited)
     return false;
 }
 
+/**********************************************************************
+ * GraphCSR()
+ * freeze the adjacency lists of the graph into the CSR arrays.
+ * - count the edges of every vertex to compute the offsets,
+ * - copy the edges in the same order as the adjacency lists.
+ * time complexity: O(V + E)
+ */
+GraphCSR::GraphCSR(Graph& g) : directed(g.is_directed()), weighted(g.is_weighted())
+{
+    int nv = g.number_vertices();
+
+    vertices.reserve(nv);
+    for (int i = 0; i < nv; ++i) {
+        vertices.push_back(g.get_vertex(i));
+        index_map.emplace(vertices[i], i);
+    }
+
+    offsets.assign(nv + 1, 0);
+    for (int i = 0; i < nv; ++i) {
+        offsets[i + 1] = offsets[i] + g.edge_lists[i].size();
+    }
+
+    targets.resize(offsets[nv]);
+    weights.resize(offsets[nv]);
+    for (int i = 0; i < nv; ++i) {
+        int k = offsets[i];
+        for (Edge& e : g.edge_lists[i]) {
+            targets[k] = e.dst_index;
+            weights[k] = e.weight;
+            ++k;
+        }
+    }
+}
+/**********************************************************************
+ * get_index()
+ * return the index (position) of the vertex, -1 if not found.
+ */
+int GraphCSR::get_index(Vertex v)
+{
+    auto it = index_map.find(v);
+    return it == index_map.end() ? -1 : it->second;
+}
+/**********************************************************************
+ * get_vertex()
+ * return the vertex value by the index
+ */
+Vertex GraphCSR::get_vertex(int index)
+{
+    if (index >= 0 && index < (int)vertices.size()) {
+        return vertices[index];
+    }
+    return UINT_MAX;
+}
+/**********************************************************************
+ * algorithm_shortest_path
+ * + the same BFS as Graph::algorithm_shortest_path() on the CSR arrays.
+ * + previous[] keeps the indexes, converted to vertices for the path.
+ */
+int GraphCSR::algorithm_shortest_path(Vertex s, Vertex d, vector<Vertex>& path)
+{
+    int  nv = number_vertices();
+
+    int si = get_index(s);
+    int di = get_index(d);
+    if (si < 0 || di < 0) {
+        return COST_MAX;
+    }
+    vector<int>  distances(nv, COST_MAX);
+    distances[si] = 0;
+
+    vector<int> previous(nv, -1);
+
+    queue<int> Q;
+    Q.push(si);
+
+    vector<bool> visited(nv, false);
+    visited[si] = true;
+
+    // BFS
+    while (!Q.empty()) {
+        int vi = Q.front();
+        Q.pop();
+
+        for (int k = offsets[vi]; k < offsets[vi + 1]; ++k) {
+            int ti = targets[k];
+            if (distances[vi] + weights[k] < distances[ti]) {
+                distances[ti] = distances[vi] + weights[k];
+                previous[ti] = vi;
+                if (!visited[ti]) {
+                    Q.push(ti);
+                    visited[ti] = true;
+                }
+            }
+        }
+    }
+
+    // obtain the shortest path (vertices)
+    if (distances[di] < (int)COST_MAX) {
+        for (int vi = di; vi >= 0; vi = previous[vi]) {
+            path.push_back(vertices[vi]);
+            if (vi == si) {
+                break;
+            }
+        }
+        reverse(path.begin(), path.end());
+    }
+    return  distances[di];
+}
+/**********************************************************************
+ * Algorithm Bellman Ford on the CSR arrays,
+ * see Graph::algorithm_bellman_ford().
+ */
+bool GraphCSR::algorithm_bellman_ford(Vertex start, int *distances)
+{
+    int nv = number_vertices();
+    for (int i = 0; i < nv; i++) {
+        distances[i] = COST_MAX;
+    }
+
+    int s = get_index(start);
+    if (s < 0) {
+        return true;
+    }
+    distances[s] = 0;
+
+    // relax all vertices, one more round to check the negative cycle
+    for (int round = 0; round < nv; ++round) {
+        bool changed = false;
+        for (int i = 0; i < nv; ++i) {
+            int vi = (i + s) % nv;
+            if (distances[vi] == COST_MAX) {
+                continue;
+            }
+            for (int k = offsets[vi]; k < offsets[vi + 1]; ++k) {
+                int ti = targets[k];
+                if (distances[vi] + weights[k] < distances[ti]) {
+                    distances[ti] = distances[vi] + weights[k];
+                    changed = true;
+                }
+            }
+        }
+        if (!changed) {
+            return true;
+        }
+    }
+    return false;
+}
+/**********************************************************************
+ * Parallel Bellman Ford on the CSR arrays
+ * + the edge array (targets[]) is split into equal parts, one part for
+ *   every worker of the pool, so the high degree vertices are shared.
+ *   a worker finds the source vertex of its first edge by a binary
+ *   search on offsets[].
+ * + the distances are lowered by compare-and-swap, a worker could see
+ *   the distances lowered by others in the same round, it only makes
+ *   the round relax more paths.
+ * + the rounds, the early exit and the negative cycle check are the
+ *   same as algorithm_bellman_ford().
+ */
+bool GraphCSR::algorithm_parallel_bellman_ford(Vertex start, ThreadPool& pool, int *distances)
+{
+    int nv = number_vertices();
+    int ne = targets.size();
+    vector<atomic<int>> shared(nv);
+    for (int i = 0; i < nv; i++) {
+        shared[i].store(COST_MAX, memory_order_relaxed);
+    }
+
+    int s = get_index(start);
+    if (s >= 0) {
+        shared[s].store(0, memory_order_relaxed);
+    }
+
+    bool no_negative_cycle = true;
+    int nt = pool.size();
+    for (int round = 0; s >= 0 && round < nv; ++round) {
+        atomic<bool> changed(false);
+        pool.run([&](int id) {
+            int k_begin = (long)ne * id / nt;
+            int k_end = (long)ne * (id + 1) / nt;
+            int vi = upper_bound(offsets.begin(), offsets.end(), k_begin) - offsets.begin() - 1;
+            bool lowered = false;
+            for (int k = k_begin; k < k_end; ++k) {
+                while (offsets[vi + 1] <= k) {
+                    ++vi;
+                }
+                int dv = shared[vi].load(memory_order_relaxed);
+                if (dv == COST_MAX) {
+                    continue;
+                }
+                int nd = dv + weights[k];
+                int dt = shared[targets[k]].load(memory_order_relaxed);
+                while (nd < dt) {
+                    if (shared[targets[k]].compare_exchange_weak(dt, nd, memory_order_relaxed)) {
+                        lowered = true;
+                        break;
+                    }
+                }
+            }
+            if (lowered) {
+                changed.store(true, memory_order_relaxed);
+            }
+        });
+        if (!changed) {
+            break;
+        }
+        if (round == nv - 1) {
+            no_negative_cycle = false;
+        }
+    }
+
+    for (int i = 0; i < nv; i++) {
+        distances[i] = shared[i].load(memory_order_relaxed);
+    }
+    return no_negative_cycle;
+}
+/**********************************************************************
+ * Kahn's Topological Sorting on the CSR arrays,
+ * see Graph::topological_sort().
+ */
+void GraphCSR::topological_sort(vector<Vertex>& topo_sort)
+{
+    int nv = number_vertices();
+
+    // calculate the indegrees for every vertex
+    vector<int> indegrees(nv, 0);
+    for (int ti : targets) {
+        indegrees[ti]++;
+    }
+
+    // find vertices tht have no incoming edges
+    queue<int> no_incoming;
+    for (int i = 0; i < nv; i++) {
+        if (indegrees[i] == 0) {
+            no_incoming.push(i);
+        }
+    }
+
+    while ( !no_incoming.empty() ) {
+        int i = no_incoming.front();
+        no_incoming.pop();
+        topo_sort.push_back(vertices[i]);
+        for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+            int ti = targets[k];
+            indegrees[ti]--;
+            if (indegrees[ti] == 0) {
+                no_incoming.push(ti);
+            }
+        }
+    }
+}
+/**********************************************************************
+ * Prim's Minimum Spanning Tree (Forest) on the CSR arrays,
+ * see Graph::algorithm_mst_prim().
+ */
+void GraphCSR::algorithm_mst_prim(Vertex v0, vector<Edge>& mst)
+{
+    int nv = number_vertices();
+    int ri = get_index(v0);
+    if (ri < 0) {
+        return;
+    }
+
+    vector<bool> selected(nv, false);
+    vector<int>  link(nv, -1);
+    IndexedHeap<Weight> Q(nv);
+
+    for (int i = 0; i < nv; ++i, ri = (ri + 1) % nv) {
+        if (selected[ri]) {
+            continue;
+        }
+        Q.push(ri, 0);
+        while (Q.get_size() > 0) {
+            int vi = Q.pop();
+            selected[vi] = true;
+            if (link[vi] >= 0) {
+                mst.emplace_back(vertices[link[vi]], vertices[vi], Q.get_key(vi), vi);
+            }
+            for (int k = offsets[vi]; k < offsets[vi + 1]; ++k) {
+                int ti = targets[k];
+                if (selected[ti]) {
+                    continue;
+                }
+                if ( !Q.contains(ti) ) {
+                    link[ti] = vi;
+                    Q.push(ti, weights[k]);
+                }
+                else if (weights[k] < Q.get_key(ti)) {
+                    link[ti] = vi;
+                    Q.decrease_key(ti, weights[k]);
+                }
+            }
+        }
+    }
+}
+/**********************************************************************
+ * Detect Cycle using DFS on the CSR arrays,
+ * see Graph::detect_cycle_dfs().
+ */
+bool GraphCSR::detect_cycle_dfs(int vi, int pi, vector<int>& visited)
+{
+    visited[vi] = true;
+    cout << vi << "(" << char(get_vertex(vi)) << "), ";
+    for (int k = offsets[vi]; k < offsets[vi + 1]; ++k) {
+        int ti = targets[k];
+        if (!visited[ti]) {
+            return detect_cycle_dfs(ti, vi, visited);
+        }
+        else if (ti != pi) {
+            cout << ti << "(" << char(get_vertex(ti)) << ") = cycle ";
+            return true;
+        }
+    }
+    return false;
+}
+
+/**********************************************************************
+ * ThreadPool()
+ * start (n) worker threads, at least one.
+ */
+ThreadPool::ThreadPool(int n) : generation(0), running(0), stopping(false)
+{
+    n = max(n, 1);
+    for (int id = 0; id < n; ++id) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, id);
+    }
+}
+/**********************************************************************
+ * ~ThreadPool()
+ * wake up the workers to stop, and wait for them.
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(pool_lock);
+        stopping = true;
+    }
+    task_ready.notify_all();
+    for (thread& t : workers) {
+        t.join();
+    }
+}
+/**********************************************************************
+ * worker_loop()
+ * wait for a new task (generation), run it, and report it is done.
+ */
+void ThreadPool::worker_loop(int id)
+{
+    unsigned long seen = 0;
+    unique_lock<mutex> lock(pool_lock);
+    while (true) {
+        task_ready.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        lock.unlock();
+        task(id);
+        lock.lock();
+        if (--running == 0) {
+            task_done.notify_one();
+        }
+    }
+}
+/**********************************************************************
+ * run()
+ * run the task on all the workers, return when all of them finish.
+ */
+void ThreadPool::run(function<void (int)> f)
+{
+    unique_lock<mutex> lock(pool_lock);
+    task = f;
+    running = workers.size();
+    ++generation;
+    task_ready.notify_all();
+    task_done.wait(lock, [&] { return running == 0; });
+}
+/**********************************************************************
+ * build_incoming()
+ * build the CSR arrays of the incoming edges (the transpose graph),
+ * the bottom-up BFS looks for the parents through them.
+ * the undirected graph does not need them.
+ */
+void GraphCSR::build_incoming()
+{
+    int nv = number_vertices();
+    in_offsets.assign(nv + 1, 0);
+    for (int ti : targets) {
+        in_offsets[ti + 1]++;
+    }
+    for (int i = 0; i < nv; ++i) {
+        in_offsets[i + 1] += in_offsets[i];
+    }
+    in_sources.resize(targets.size());
+    vector<int> fill(in_offsets.begin(), in_offsets.end() - 1);
+    for (int i = 0; i < nv; ++i) {
+        for (int k = offsets[i]; k < offsets[i + 1]; ++k) {
+            in_sources[fill[targets[k]]++] = i;
+        }
+    }
+}
+/**********************************************************************
+ * Breadth First Search on the CSR arrays
+ * + the queue based BFS, every edge has the same cost (one hop).
+ * output:
+ *   (vector<int>)depths  - the number of hops from s, -1 if not reached.
+ *   (vector<int>)parents - the index of the parent vertex on the BFS tree,
+ *                          it is the source itself for s, -1 if not reached.
+ */
+void GraphCSR::algorithm_bfs(Vertex s, vector<int>& depths, vector<int>& parents)
+{
+    int nv = number_vertices();
+    depths.assign(nv, -1);
+    parents.assign(nv, -1);
+
+    int si = get_index(s);
+    if (si < 0) {
+        return;
+    }
+    depths[si] = 0;
+    parents[si] = si;
+
+    queue<int> Q;
+    Q.push(si);
+    while (!Q.empty()) {
+        int vi = Q.front();
+        Q.pop();
+        for (int k = offsets[vi]; k < offsets[vi + 1]; ++k) {
+            int ti = targets[k];
+            if (depths[ti] < 0) {
+                depths[ti] = depths[vi] + 1;
+                parents[ti] = vi;
+                Q.push(ti);
+            }
+        }
+    }
+}
+/**********************************************************************
+ * Parallel Direction Optimizing BFS (Beamer, Asanovic and Patterson)
+ * + level synchronous, the workers of the pool expand one level of the
+ *   frontier together, the frontier and the visited vertices are bitmaps.
+ * + top-down step: the vertices in the frontier visit their outgoing
+ *   edges, a vertex is claimed by the first parent that sets it (CAS).
+ * + bottom-up step: the unvisited vertices look for a parent in the
+ *   frontier through their incoming edges, and stop at the first one.
+ *   each worker owns whole bitmap words, so no vertex is shared.
+ * + it switches to bottom-up when the edges of the frontier (mf) are
+ *   more than the edges not explored (mu) / ALPHA, and back to top-down
+ *   when the frontier (nf) is less than the vertices (n) / BETA.
+ * + the workers take the bitmap words in blocks to balance the load.
+ * output: the same as algorithm_bfs(), the parents could be different
+ *   but at the same depths.
+ */
+#define BFS_ALPHA       14      // top-down to bottom-up: mf > mu / ALPHA
+#define BFS_BETA        24      // bottom-up to top-down: nf < n / BETA
+#define BFS_BLOCK       16      // bitmap words (64 vertices) taken at a time
+
+void GraphCSR::algorithm_parallel_bfs(Vertex s, ThreadPool& pool, vector<int>& depths, vector<int>& parents)
+{
+    int nv = number_vertices();
+    depths.assign(nv, -1);
+    parents.assign(nv, -1);
+
+    int si = get_index(s);
+    if (si < 0) {
+        return;
+    }
+    if (is_directed() && in_offsets.empty()) {
+        build_incoming();
+    }
+    const vector<int>& up_offsets = is_directed() ? in_offsets : offsets;
+    const vector<int>& up_sources = is_directed() ? in_sources : targets;
+
+    int nw = (nv + 63) / 64;
+    vector<atomic<uint64_t>> frontier(nw), next(nw), visited(nw);
+    vector<atomic<int>> claimed(nv);
+    for (int i = 0; i < nv; ++i) {
+        claimed[i].store(-1, memory_order_relaxed);
+    }
+
+    depths[si] = 0;
+    claimed[si].store(si, memory_order_relaxed);
+    frontier[si >> 6].store(1UL << (si & 63), memory_order_relaxed);
+    visited[si >> 6].store(1UL << (si & 63), memory_order_relaxed);
+
+    long frontier_size = 1;
+    long frontier_edges = offsets[si + 1] - offsets[si];
+    long unexplored_edges = targets.size() - frontier_edges;
+    bool bottom_up = false;
+
+    for (int level = 0; frontier_size > 0; ++level) {
+        if (!bottom_up && frontier_edges > unexplored_edges / BFS_ALPHA) {
+            bottom_up = true;
+        }
+        else if (bottom_up && frontier_size < nv / BFS_BETA) {
+            bottom_up = false;
+        }
+
+        atomic<int>  next_block(0);
+        atomic<long> next_size(0), next_edges(0);
+
+        pool.run([&](int) {
+            long local_size = 0, local_edges = 0;
+            for (int b = next_block++; b * BFS_BLOCK < nw; b = next_block++) {
+                int w_end = min(nw, (b + 1) * BFS_BLOCK);
+                for (int w = b * BFS_BLOCK; w < w_end; ++w) {
+                    if (bottom_up) {
+                        uint64_t unvisited = ~visited[w].load(memory_order_relaxed);
+                        uint64_t found = 0;
+                        for ( ; unvisited; unvisited &= unvisited - 1) {
+                            int vi = (w << 6) + __builtin_ctzl(unvisited);
+                            if (vi >= nv) {
+                                break;
+                            }
+                            for (int k = up_offsets[vi]; k < up_offsets[vi + 1]; ++k) {
+                                int ui = up_sources[k];
+                                if (frontier[ui >> 6].load(memory_order_relaxed) & (1UL << (ui & 63))) {
+                                    claimed[vi].store(ui, memory_order_relaxed);
+                                    depths[vi] = level + 1;
+                                    found |= 1UL << (vi & 63);
+                                    local_size++;
+                                    local_edges += offsets[vi + 1] - offsets[vi];
+                                    break;
+                                }
+                            }
+                        }
+                        if (found) {
+                            next[w].fetch_or(found, memory_order_relaxed);
+                            visited[w].fetch_or(found, memory_order_relaxed);
+                        }
+                    }
+                    else {
+                        uint64_t bits = frontier[w].load(memory_order_relaxed);
+                        for ( ; bits; bits &= bits - 1) {
+                            int ui = (w << 6) + __builtin_ctzl(bits);
+                            for (int k = offsets[ui]; k < offsets[ui + 1]; ++k) {
+                                int vi = targets[k];
+                                uint64_t mask = 1UL << (vi & 63);
+                                if (visited[vi >> 6].load(memory_order_relaxed) & mask) {
+                                    continue;
+                                }
+                                int expected = -1;
+                                if (claimed[vi].compare_exchange_strong(expected, ui, memory_order_relaxed)) {
+                                    depths[vi] = level + 1;
+                                    next[vi >> 6].fetch_or(mask, memory_order_relaxed);
+                                    visited[vi >> 6].fetch_or(mask, memory_order_relaxed);
+                                    local_size++;
+                                    local_edges += offsets[vi + 1] - offsets[vi];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            next_size += local_size;
+            next_edges += local_edges;
+        });
+
+        frontier.swap(next);
+        for (int w = 0; w < nw; ++w) {
+            next[w].store(0, memory_order_relaxed);
+        }
+        frontier_size = next_size;
+        frontier_edges = next_edges;
+        unexplored_edges -= frontier_edges;
+    }
+
+    for (int i = 0; i < nv; ++i) {
+        parents[i] = claimed[i].load(memory_order_relaxed);
+    }
+}
+
 /**********************************************************************
  * the following code uses the adjacent tables, like ...
  */
@@ -713,12 +1640,12 @@ void graph_dijkstra_algorithm(vector<vector<unsigned int>>& g,
  * algorithm:
  *   1. remove self circle and parallel edges.
  *   2. build and sort the edges according to their weights.
- *   3. treat each edge as a single node tree, 
- *      when the edge e.dst on a different tree (has a different tid),
- *      merge the trees by assign it with the same tree id (tid).
+ *   3. treat each vertex as a single node tree (disjoint set),
+ *      when the edge e.dst on a different tree than e.src,
+ *      take the edge and unite the two trees.
  *   4. go through the ordered edges from the begin to the end.
- * note:
- *   this impelemtation can be improved by using Disjoint Set Data Structure.
+ * time complexity: O(V*V + E*log(E)), the V*V is to scan the matrix.
+ * see also Graph::algorithm_mst_kruskal() for the adjacency lists.
  */
 void graph_kruskal_algorithm(vector<vector<unsigned int>>& g, 
                              vector<Edge>& mst)
@@ -726,43 +1653,19 @@ void graph_kruskal_algorithm(vector<vector<unsigned int>>& g,
     int sz = g.size();
     vector<Edge> edges;
     for (int u = 0; u < sz; u++) {
-        for (int v = u; v < sz; v++) {
+        for (int v = u + 1; v < sz; v++) {
             if ( g[u][v] ) {
-                Edge e(u, v, g[u][v]);
-                if ( edges.empty() || edges.back().weight <= e.weight ) {
-                    edges.push_back(e);
-                }
-                else { 
-                    vector<Edge>::iterator it;
-                    for (it = edges.begin(); it < edges.end(); it++) {
-                        if ((*it).weight > e.weight) {
-                            edges.insert(it, e);
-                            break;
-                        }
-                    }
-                }
+                edges.emplace_back(u, v, g[u][v]);
             }
         }
     }
-    // for (auto e : edges) {
-    //     cout << e.src << "-" << e.dst << "." << e.weight << ", ";
-    // }
-    // cout << endl;
-
-    vector<int> tid(sz);
-    for (int i = 0; i < sz; ++i) {
-        tid[i] = i;
-    }
+    stable_sort(edges.begin(), edges.end(),
+                [](const Edge& e1, const Edge& e2) { return e1.weight < e2.weight; });
 
+    DisjointSet trees(sz);
     for (Edge e : edges) {
-        if (tid[e.src] != tid[e.dst]) {
+        if (trees.unite(e.src, e.dst)) {
             mst.push_back(e);
-            int ts = tid[e.src], td = tid[e.dst];
-            for (int i = 0; i < sz; ++i) {
-                if (tid[i] == ts) {
-                    tid[i] = td;
-                }
-            }
         }
     }
 }
@@ -803,6 +1706,30 @@ Graph* graph_create_G1()
     return g;
 }
 //
+Graph* graph_create_G2()
+{
+    Graph *g = new Graph();
+    g->add_edge('A', 'B', 3);   //   A---B   E---F
+    g->add_edge('A', 'C', 1);   //   |  /    |  /
+    g->add_edge('B', 'C', 1);   //   | /     | /
+    g->add_edge('C', 'D', 4);   //   C---D   G
+    g->add_edge('E', 'F', 2);
+    g->add_edge('E', 'G', 5);
+    g->add_edge('F', 'G', 1);
+    return g;
+}
+//
+Graph* graph_create_G4()
+{
+    Graph *g = new Graph(true, true);
+    g->add_edge('A', 'B', 4);   // A--4-->B--(-2)-->D
+    g->add_edge('A', 'C', 5);   // |      ^         |
+    g->add_edge('C', 'B', -3);  // 5     -3         2
+    g->add_edge('B', 'D', -2);  // |      |         v
+    g->add_edge('D', 'E', 2);   // +----->C         E
+    return g;
+}
+//
 Graph* graph_create_G3()
 {
     Graph *g = new Graph(true, false);
@@ -817,6 +1744,17 @@ Graph* graph_create_G3()
     return g;
 }
 //
+// random weighted graph for the benchmarks,
+// the vertices start from 256 so they are never taken as NOT_VERTEX.
+Graph* graph_create_random(int nv, int ne, bool directed)
+{
+    Graph *g = new Graph(directed, true);
+    for (int i = 0; i < ne; ++i) {
+        g->add_edge(256 + rand() % nv, 256 + rand() % nv, 1 + rand() % 100);
+    }
+    return g;
+}
+//
 void graph_display_distance(Graph *g, int *distances)
 {
     int nv = g->number_vertices();
@@ -856,7 +1794,107 @@ void graph_display_path(Graph *g, vector<Vertex>& path)
     }
 }
 //
-int main()
+#include <chrono>
+
+#define TESTING_GRAPH(s, statement) { \
+    cout << "  " << s << ": "; \
+    auto start = chrono::high_resolution_clock::now(); \
+    statement; \
+    auto end = chrono::high_resolution_clock::now(); \
+    cout << "Elapsed time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << " us" << endl; \
+}
+//
+void graph_benchmark(int nv, int ne)
+{
+    cout << "Adjacency Lists vs CSR: " << endl;
+    Graph *g;
+    TESTING_GRAPH("Build Graph          ", g = graph_create_random(nv, ne, true));
+    nv = g->number_vertices();
+    cout << "    " << nv << " vertices, " << g->number_edges() << " edges" << endl;
+    GraphCSR *c;
+    TESTING_GRAPH("Build CSR            ", c = new GraphCSR(*g));
+
+    Vertex s = g->get_vertex(0);
+    Vertex d = g->get_vertex(nv - 1);
+    vector<Vertex> path;
+    int dist_list, dist_csr;
+    TESTING_GRAPH("Shortest Path (lists)", dist_list = g->algorithm_shortest_path(s, d, path));
+    path.clear();
+    TESTING_GRAPH("Shortest Path (CSR)  ", dist_csr = c->algorithm_shortest_path(s, d, path));
+    cout << "    distance = " << dist_list << " / " << dist_csr << endl;
+
+    vector<int> distances_list(nv), distances_csr(nv), distances_spfa(nv), distances_parallel(nv);
+    TESTING_GRAPH("Bellman Ford (lists) ", g->algorithm_bellman_ford(s, distances_list.data()));
+    TESTING_GRAPH("Bellman Ford (CSR)   ", c->algorithm_bellman_ford(s, distances_csr.data()));
+    TESTING_GRAPH("SPFA (lists)         ", g->algorithm_spfa(s, distances_spfa.data()));
+    int num_threads = thread::hardware_concurrency();
+    for (int nt = 1; ; nt = min(nt * 2, num_threads)) {
+        ThreadPool pool(nt);
+        TESTING_GRAPH("Bellman Ford (" + to_string(nt) + " threads)", c->algorithm_parallel_bellman_ford(s, pool, distances_parallel.data()));
+        if (nt >= num_threads) {
+            break;
+        }
+    }
+    cout << "    same distances = " << (distances_list == distances_csr) << ", ";
+    cout << (distances_list == distances_spfa) << ", " << (distances_list == distances_parallel) << endl;
+
+    vector<Vertex> topo_list, topo_csr;
+    TESTING_GRAPH("Topo Sort (lists)    ", g->topological_sort(topo_list));
+    TESTING_GRAPH("Topo Sort (CSR)      ", c->topological_sort(topo_csr));
+    cout << "    same order = " << (topo_list == topo_csr) << endl;
+
+    cout << "Parallel BFS (direction optimizing): " << endl;
+    vector<int> depths_serial, depths_parallel, parents;
+    TESTING_GRAPH("BFS (queue)          ", c->algorithm_bfs(s, depths_serial, parents));
+    c->build_incoming();
+    for (int nt = 1; ; nt = min(nt * 2, num_threads)) {
+        ThreadPool pool(nt);
+        TESTING_GRAPH("BFS (" + to_string(nt) + " threads)      ", c->algorithm_parallel_bfs(s, pool, depths_parallel, parents));
+        if (nt >= num_threads) {
+            break;
+        }
+    }
+    cout << "    same depths = " << (depths_serial == depths_parallel);
+    cout << ", max depth = " << *max_element(depths_serial.begin(), depths_serial.end()) << endl;
+
+    cout << "Dijkstra (indexed min-heap): " << endl;
+    vector<int> previous;
+    TESTING_GRAPH("Single Source        ", g->algorithm_dijkstra(s, distances_list, previous));
+    TESTING_GRAPH("Single Pair          ", dist_list = g->algorithm_dijkstra(s, d, distances_list, previous));
+    path.clear();
+    g->get_path(d, previous, path);
+    cout << "    distance = " << dist_list << ", " << path.size() << " vertices on the path" << endl;
+
+    delete c;
+    delete g;
+
+    cout << "Minimum Spanning Forest (undirected): " << endl;
+    g = graph_create_random(nv, ne, false);
+    c = new GraphCSR(*g);
+    vector<Edge> mst;
+    long cost_prim = 0, cost_csr = 0, cost_kruskal = 0;
+    TESTING_GRAPH("Prim (lists)         ", g->algorithm_mst_prim(g->get_vertex(0), mst));
+    for (Edge& e : mst) {
+        cost_prim += e.weight;
+    }
+    mst.clear();
+    TESTING_GRAPH("Prim (CSR)           ", c->algorithm_mst_prim(c->get_vertex(0), mst));
+    for (Edge& e : mst) {
+        cost_csr += e.weight;
+    }
+    mst.clear();
+    TESTING_GRAPH("Kruskal              ", g->algorithm_mst_kruskal(mst));
+    for (Edge& e : mst) {
+        cost_kruskal += e.weight;
+    }
+    cout << "    " << mst.size() << " edges, total_cost = ";
+    cout << cost_prim << " / " << cost_csr << " / " << cost_kruskal << endl;
+
+    delete c;
+    delete g;
+}
+//
+int main(int argc, char *argv[])
 {
     int n = 10;
     int B[n];   // up tp 26 nodes for testing
@@ -927,6 +1965,22 @@ int main()
         }
     }
 
+    cout << "Dijkstra (indexed min-heap): " << endl;
+    vector<int> dijkstra_distances, dijkstra_previous;
+    for (int i = 0; i < nv; ++i) {
+        Vertex start = g1->get_vertex(i);
+        g1->algorithm_dijkstra(start, dijkstra_distances, dijkstra_previous);
+        graph_display_distance(g1, dijkstra_distances.data());
+    }
+    for (int i = 0; i < nv; ++ i) {
+        Vertex destination = g1->get_vertex(i);
+        int dist = g1->algorithm_dijkstra('B', destination, dijkstra_distances, dijkstra_previous);
+        g1->get_path(destination, dijkstra_previous, path);
+        graph_display_path(g1, path);
+        cout << "  distance = " << dist << endl;
+        path.clear();
+    }
+
     cout << "Bellman Ford: " << endl;
     for (int i = 0; i < nv; ++i) {
         Vertex start = g1->get_vertex(i);
@@ -934,6 +1988,20 @@ int main()
         graph_display_distance(g1, distances);
     }
 
+    cout << "Bellman Ford and SPFA (negative weights): G4" << endl;
+    Graph *g4 = graph_create_G4();
+    vector<int> distances4(g4->number_vertices());
+    bool no_cycle_bf = g4->algorithm_bellman_ford('A', distances4.data());
+    graph_display_distance(g4, distances4.data());
+    bool no_cycle_spfa = g4->algorithm_spfa('A', distances4.data());
+    graph_display_distance(g4, distances4.data());
+    cout << "  negative cycle: " << (no_cycle_bf && no_cycle_spfa ? "No" : "Yes") << endl;
+    g4->add_edge('E', 'C', -4);  // C->B->D->E->C = -3 - 2 + 2 - 4
+    cout << "  add edge E-->C (-4), negative cycle: ";
+    cout << (g4->algorithm_bellman_ford('A', distances4.data()) ? "No" : "Yes") << " / ";
+    cout << (g4->algorithm_spfa('A', distances4.data()) ? "No" : "Yes") << endl;
+    delete g4;
+
     cout << "Create Directed Graph: G3" << endl;
     Graph *g3 = graph_create_G3();
     g3->print_graph();
@@ -964,6 +2032,31 @@ int main()
         mst.clear();
     }
 
+    cout << "Prim's Min Spinning Forest: G2" << endl;
+    Graph *g2 = graph_create_G2();
+    g2->print_graph();
+    cout << "  Start from Vertex D: ";
+    g2->algorithm_mst_prim('D', mst);
+    int forest_cost = 0;
+    for (auto e : mst) {
+        cout << char(e.src) << "-" << char(e.dst) << "." << e.weight << ", ";
+        forest_cost += e.weight;
+    }
+    cout << "total_cost = " << forest_cost << endl;
+    mst.clear();
+    delete g2;
+
+    cout << "Kruskal's Min Spinning Tree (disjoint set): " << endl;
+    g1->algorithm_mst_kruskal(mst);
+    int kruskal_cost = 0;
+    cout << "  ";
+    for (auto e : mst) {
+        cout << char(e.src) << "-" << char(e.dst) << "." << e.weight << ", ";
+        kruskal_cost += e.weight;
+    }
+    cout << "total_cost = " << kruskal_cost << endl;
+    mst.clear();
+
     cout << "Detect Cycle using DFS: " << endl;
     // g1->print_vertices();
     // g1->print_graph();
@@ -977,6 +2070,27 @@ int main()
         cout << "No cycle in the graph." << endl;
     }
 
+    cout << "CSR (Compressed Sparse Row) of G1 and G3: " << endl;
+    GraphCSR c1(*g1);
+    GraphCSR c3(*g3);
+    cout << "  G1: " << c1.number_vertices() << " vertices, " << c1.number_edges() << " edges" << endl;
+    for (int i = 0; i < nv; ++i) {
+        c1.algorithm_bellman_ford(c1.get_vertex(i), distances);
+        graph_display_distance(g1, distances);
+    }
+    path.clear();
+    c1.algorithm_shortest_path('A', 'E', path);
+    graph_display_path(g1, path);  cout << endl;
+    topo_sort.clear();
+    c3.topological_sort(topo_sort);
+    cout << "  G3 Topological Sort: ";
+    for (auto v : topo_sort) { cout << char(v) << ", "; }  cout << endl;
+    mst.clear();
+    c1.algorithm_mst_prim('A', mst);
+    cout << "  G1 Prim's MST: ";
+    for (auto e : mst) { cout << char(e.src) << "-" << char(e.dst) << "." << e.weight << ", "; }  cout << endl;
+    mst.clear();
+
     delete g1;
     delete g3;
 
@@ -1009,6 +2123,7 @@ int main()
     cout << endl;
 
     cout << "Kruskal's Min Spinning Tree: " << endl;
+    mst.clear();
     graph_kruskal_algorithm(G1, mst);
     int cost = 0;
     cout << "  ";
@@ -1018,5 +2133,12 @@ int main()
     }
     cout << "total_cost = " << cost << endl;
 
+    // benchmarks, could take two arguments as the number of vertices and edges
+    int bench_nv = argc > 1 ? atoi(argv[1]) : 100000;
+    int bench_ne = argc > 2 ? atoi(argv[2]) : bench_nv * 8;
+    if (bench_nv > 1) {
+        graph_benchmark(bench_nv, bench_ne);
+    }
+
     return 0;
 }
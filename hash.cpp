@@ -0,0 +1,367 @@
+// Hash Table (open addressing)
+//   a hash table keeps the keys in a table of slots, the slot of a key is
+//   computed from the key by a hash function, so a key is found in O(1)
+//   on average, it doesn't need the keys to be sorted.
+//   open addressing keeps the keys in the table itself (no linked lists),
+//   when the slot of a key is taken, the next slots of its probe sequence
+//   are tried until the key or an empty slot is found.
+//
+// implementation (swiss table):
+//   - the slots are split into groups of 16, every slot has a control byte:
+//     empty (0x80), deleted (0xfe), or the low 7 bits of the key hash (h2)
+//     when the slot is full.
+//   - the high bits of the hash (h1) choose the first group, the groups are
+//     probed in a triangular sequence (1, 2, 3 ... groups apart), which
+//     visits every group when the number of groups is a power of 2.
+//   - the 16 control bytes of a group are compared with h2 at once by
+//     SSE2 (one compare, one movemask), only the slots with a matching h2
+//     (1/128 false matches) compare their keys. a probe stops at the first
+//     group with an empty slot.
+//   - the table grows (doubles) when 7/8 of the slots are full or deleted.
+//   - erase marks the slot empty when its group has an empty slot (no probe
+//     sequence goes past that group), otherwise deleted (a tombstone).
+//
+//   HashMap<V> maps the long keys to the values of V,
+//   HashIndex finds a key of an unsorted array, the index of its first
+//   occurrence, it is built from the array in bulk.
+//
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+// the control bytes of a group are matched by SSE2 on x86
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#include <emmintrin.h>
+#define HASH_SIMD
+#endif
+
+using namespace std;
+
+#define HASH_GROUP      16
+#define HASH_EMPTY      ((int8_t)0x80)
+#define HASH_DELETED    ((int8_t)0xfe)
+
+/* hash_long:
+ *   the 64-bit finalizer of murmur3, every bit of the key changes about
+ *   half of the bits of the hash, so h1 and h2 are independent enough.
+ */
+static inline uint64_t hash_long(long key)
+{
+    uint64_t h = (uint64_t)key;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+/* hash_group_match:
+ *   return the bit mask of the control bytes equal to c in a group.
+ */
+static inline unsigned hash_group_match(const int8_t *ctrl, int8_t c)
+{
+#ifdef HASH_SIMD
+    __m128i group = _mm_load_si128((const __m128i*)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(c)));
+#else
+    unsigned mask = 0;
+    for (int i = 0; i < HASH_GROUP; ++i) {
+        mask |= (unsigned)(ctrl[i] == c) << i;
+    }
+    return mask;
+#endif
+}
+/* hash_group_free:
+ *   return the bit mask of the empty or deleted slots in a group,
+ *   both have the sign bit set, the full slots (h2) don't.
+ */
+static inline unsigned hash_group_free(const int8_t *ctrl)
+{
+#ifdef HASH_SIMD
+    return _mm_movemask_epi8(_mm_load_si128((const __m128i*)ctrl));
+#else
+    unsigned mask = 0;
+    for (int i = 0; i < HASH_GROUP; ++i) {
+        mask |= (unsigned)(ctrl[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+template <typename V>
+class HashMap {
+protected:
+    size_t  groups;         // number of groups, power of 2
+    size_t  count;          // full slots
+    size_t  used;           // full and deleted slots
+    int8_t *ctrl;           // the control bytes, 16-byte aligned
+    vector<long> keys;
+    vector<V>    values;
+
+    size_t capacity() const { return groups * HASH_GROUP; }
+
+    void allocate(size_t ngroups) {
+        groups = ngroups;
+        count = used = 0;
+        ctrl = static_cast<int8_t*>(::operator new(capacity(), align_val_t(HASH_GROUP)));
+        memset(ctrl, HASH_EMPTY, capacity());
+        keys.assign(capacity(), 0);
+        values.assign(capacity(), V());
+    }
+    void release() {
+        ::operator delete(ctrl, align_val_t(HASH_GROUP));
+        ctrl = NULL;
+    }
+    /* find_slot: the slot of the key, or capacity() if not found.
+     */
+    size_t find_slot(long key) const {
+        uint64_t h = hash_long(key);
+        int8_t h2 = h & 0x7f;
+        size_t g = (h >> 7) & (groups - 1);
+        for (size_t step = 1; ; ++step) {
+            const int8_t *group = ctrl + g * HASH_GROUP;
+            for (unsigned mask = hash_group_match(group, h2); mask; mask &= mask - 1) {
+                size_t slot = g * HASH_GROUP + __builtin_ctz(mask);
+                if (keys[slot] == key) {
+                    return slot;
+                }
+            }
+            if (hash_group_match(group, HASH_EMPTY)) {
+                return capacity();
+            }
+            g = (g + step) & (groups - 1);
+        }
+    }
+    /* free_slot: the first empty or deleted slot on the probe sequence
+     *   of a key which is not in the table.
+     */
+    size_t free_slot(uint64_t h) const {
+        size_t g = (h >> 7) & (groups - 1);
+        for (size_t step = 1; ; ++step) {
+            unsigned mask = hash_group_free(ctrl + g * HASH_GROUP);
+            if (mask) {
+                return g * HASH_GROUP + __builtin_ctz(mask);
+            }
+            g = (g + step) & (groups - 1);
+        }
+    }
+    /* rehash: move the full slots into a table of ngroups groups,
+     *   the deleted slots are dropped.
+     */
+    void rehash(size_t ngroups) {
+        int8_t *old_ctrl = ctrl;
+        size_t old_capacity = capacity();
+        vector<long> old_keys;
+        vector<V>    old_values;
+        old_keys.swap(keys);
+        old_values.swap(values);
+        allocate(ngroups);
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                uint64_t h = hash_long(old_keys[i]);
+                size_t slot = free_slot(h);
+                ctrl[slot] = h & 0x7f;
+                keys[slot] = old_keys[i];
+                values[slot] = std::move(old_values[i]);
+                ++count;
+            }
+        }
+        used = count;
+        ::operator delete(old_ctrl, align_val_t(HASH_GROUP));
+    }
+    /* groups_for: the groups to keep n keys under the 7/8 load factor.
+     */
+    static size_t groups_for(size_t n) {
+        size_t g = 1;
+        while (g * HASH_GROUP * 7 / 8 < n) { g <<= 1; }
+        return g;
+    }
+
+public:
+    HashMap(size_t n = 0) { allocate(groups_for(n)); }
+    HashMap(const HashMap& other) = delete;
+    HashMap& operator=(const HashMap& other) = delete;
+    ~HashMap() { release(); }
+
+    size_t get_size() const { return count; }
+    bool contains(long key) const { return find_slot(key) != capacity(); }
+
+    /* find:
+     *   return the value of the key, NULL if the key is not in the table.
+     */
+    V *find(long key) {
+        size_t slot = find_slot(key);
+        return slot == capacity() ? NULL : &values[slot];
+    }
+    const V *find(long key) const {
+        size_t slot = find_slot(key);
+        return slot == capacity() ? NULL : &values[slot];
+    }
+    /* insert:
+     *   add the key and its value if the key is not in the table.
+     *   return: false if the key is already in, its value is not changed.
+     */
+    bool insert(long key, const V& value) {
+        if (find_slot(key) != capacity()) {
+            return false;
+        }
+        if ((used + 1) * 8 > capacity() * 7) {
+            // grow if half of the 7/8 are full, otherwise drop the tombstones
+            rehash(count * 16 >= capacity() * 7 ? groups * 2 : groups);
+        }
+        uint64_t h = hash_long(key);
+        size_t slot = free_slot(h);
+        used += ctrl[slot] == HASH_EMPTY;
+        ++count;
+        ctrl[slot] = h & 0x7f;
+        keys[slot] = key;
+        values[slot] = value;
+        return true;
+    }
+    V& operator[](long key) {
+        size_t slot = find_slot(key);
+        if (slot == capacity()) {
+            insert(key, V());
+            slot = find_slot(key);
+        }
+        return values[slot];
+    }
+    /* erase:
+     *   return: false if the key is not in the table.
+     */
+    bool erase(long key) {
+        size_t slot = find_slot(key);
+        if (slot == capacity()) {
+            return false;
+        }
+        const int8_t *group = ctrl + slot / HASH_GROUP * HASH_GROUP;
+        if (hash_group_match(group, HASH_EMPTY)) {
+            ctrl[slot] = HASH_EMPTY;
+            --used;
+        } else {
+            ctrl[slot] = HASH_DELETED;
+        }
+        --count;
+        values[slot] = V();
+        return true;
+    }
+    void clear() {
+        release();
+        allocate(1);
+    }
+    /* reserve:
+     *   make room for n keys, no rehash until then.
+     */
+    void reserve(size_t n) {
+        if (groups_for(n) > groups) {
+            rehash(groups_for(n));
+        }
+    }
+};
+
+/* HashIndex
+ *   the hash search of an unsorted array: map every key to the index of
+ *   its first occurrence in the array.
+ * build: reserve the table for sz keys once, then insert the keys in
+ *        order, the later duplicates are not inserted.
+ * time complexity: build O(n), search O(1) on average
+ * space complexity: O(n)
+ */
+class HashIndex : public HashMap<int> {
+public:
+    HashIndex() { }
+    HashIndex(const long a[], int sz) { build(a, sz); }
+
+    void build(const long a[], int sz) {
+        clear();
+        reserve(sz);
+        for (int i = 0; i < sz; ++i) {
+            insert(a[i], i);
+        }
+    }
+    /* search:
+     *   return the index of the key in the array, -1 if not found.
+     */
+    int search(long key) const {
+        const int *i = find(key);
+        return i == NULL ? -1 : *i;
+    }
+};
+
+/* testing driver code,
+ *   define HASH_LIBRARY before including this file to use the hash tables
+ *   without the testing driver.
+ */
+#ifndef HASH_LIBRARY
+#include <chrono>
+#include <random>
+#include <unordered_map>
+
+#define TESTING_HASH(s, ...) { \
+    cout << "\e[1m" << s << "\e[0m" << ": "; \
+    auto start = chrono::high_resolution_clock::now(); \
+    __VA_ARGS__; \
+    auto end = chrono::high_resolution_clock::now(); \
+    cout << "Elapsed time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << " us"; \
+}
+/* hash_benchmark:
+ *   build a table of n random keys, then look up q keys, half of them
+ *   are not in, HashMap against std::unordered_map.
+ */
+void hash_benchmark(int n, int q)
+{
+    mt19937_64 rng(1);
+    vector<long> a(n), keys(q);
+    for (int i = 0; i < n; ++i) { a[i] = rng(); }
+    for (int j = 0; j < q; ++j) { keys[j] = (j & 1) ? (long)rng() : a[rng() % n]; }
+
+    cout << "---- hash benchmark, n = " << n << ", queries = " << q << " ----" << endl;
+    long found = 0;
+    HashIndex index;
+    TESTING_HASH("HashIndex build         ", index.build(a.data(), n));
+    cout << endl;
+    TESTING_HASH("HashIndex search        ", for (int j = 0; j < q; ++j) { found += index.search(keys[j]) >= 0; });
+    cout << ", found = " << found << endl;
+
+    found = 0;
+    unordered_map<long, int> m;
+    TESTING_HASH("unordered_map build     ", m.reserve(n); for (int i = 0; i < n; ++i) { m.emplace(a[i], i); });
+    cout << endl;
+    TESTING_HASH("unordered_map search    ", for (int j = 0; j < q; ++j) { found += m.find(keys[j]) != m.end(); });
+    cout << ", found = " << found << endl;
+}
+/* testing main
+ *   could take the number of keys and queries to run the benchmark.
+ */
+int main(int argc, char *argv[])
+{
+    HashMap<int> m;
+    cout << "---- insert 0, 10, 20 ... 190 ----" << endl;
+    for (int i = 0; i < 20; ++i) { m.insert(i * 10, i); }
+    cout << "size = " << m.get_size() << endl;
+    cout << "find 50: " << *m.find(50) << ", find 55: " << (m.find(55) ? "found" : "not found") << endl;
+    m.erase(50);
+    m[55] = 99;
+    cout << "erase 50, set 55 = 99, size = " << m.get_size() << endl;
+    cout << "find 50: " << (m.find(50) ? "found" : "not found") << ", find 55: " << *m.find(55) << endl;
+
+    long A[] = { 42, 7, 19, 7, -3, 88, 42, 1000000007 };
+    int n = sizeof(A) / sizeof(A[0]);
+    HashIndex index(A, n);
+    cout << "---- hash index of A[] = ";
+    for (int i = 0; i < n; ++i) { cout << A[i] << (i + 1 < n ? ", " : " ----\n"); }
+    for (long key : { 7L, 42L, -3L, 1000000007L, 5L }) {
+        cout << "search " << key << ": " << index.search(key) << endl;
+    }
+
+    if (argc > 1) {
+        int bench_n = atoi(argv[1]);
+        int bench_q = argc > 2 ? atoi(argv[2]) : bench_n;
+        hash_benchmark(bench_n, bench_q);
+    }
+    return 0;
+}
+#endif  // HASH_LIBRARY
@@ -2,7 +2,10 @@
 //   it is a special completed binary tree. there are three types of heaps:
 //   1) max heap, the node value is greater than the children, the root is the max.
 //   2) min heap, the node value is less than the children, the root is the min.
-//   3) min-max heap, the values are alternated on levels. // not implemented
+//   3) min-max heap, the values are alternated on levels, the nodes on the
+//      even levels (min levels) are less than their descendants, the nodes
+//      on the odd levels (max levels) are greater than their descendants.
+//      the root is the min, the max is one of the two children of the root.
 //
 // implementation:
 //   the heap class implements a k-ary min-heap or max-heap for any data types.
@@ -10,13 +13,54 @@
 //   the heap is represented by vector, each node (i) has k children.
 //   the index of a child is: i * k + m; 1 <= m <= k.
 //   it is a binary heap when k is equal to 2.
+//   Heap<T, Compare, K> takes the order and k at compile time, HeapTree,
+//   MinHeap and MaxHeap take the type and k at run time on top of it.
 //   the root is the first element, index is 0. 
 //   the root is minimum when the heap is min-heap.
 //   the root is maximum when the heap is max-heap.
 //
+// indexed heap:
+//   a k-ary min-heap or max-heap of handles (0..n-1), every handle has a
+//   key (priority). a position map finds a handle in the heap, so the key
+//   of a handle can be changed in place, or the handle can be erased,
+//   without pushing it again.
+//
+// pairing heap:
+//   a heap ordered multiway tree of nodes, two pairing heaps are melded in
+//   O(1) by linking the roots and splicing the node pools, pop takes
+//   O(log n) amortized time. it fits the workloads which merge many
+//   priority queues.
+//
+// loser tree (tournament tree):
+//   k sources play a knockout tournament, every internal node keeps the
+//   loser of its game and the winner goes up. after the winner is taken,
+//   only the games on the path of its source are replayed, one comparison
+//   per level (log2(k)), against the losers kept on the path. it merges
+//   k sorted runs (arrays, lists, files) into one sorted output.
+//
+// multiqueue (concurrent priority queue):
+//   a number of heap shards, each with its own lock. push goes to a random
+//   shard, pop takes the better root of two random shards. the threads
+//   rarely wait on the same lock, but the order is relaxed (see MultiQueue).
+//
+// cache aligned heap:
+//   a k-ary heap touches one cache line per level when the k children of
+//   every node are in one cache line: k = 64 / sizeof(T), and the array
+//   is aligned and shifted by k - 1 elements, so the first child of every
+//   node (k * i + 1) starts a cache line when sizeof(T) divides 64 (the
+//   groups drift across the lines for the other sizes). it takes log_k(n)
+//   cache misses per sift-down instead of log2(n), for the heaps larger
+//   than the caches.
+//
+// top-k:
+//   the k largest elements of a stream are kept in a min-heap of size k,
+//   its root is the smallest one kept, a new element replaces the root
+//   only when it is larger. O(n*log(k)) time and O(k) space.
+//
 // applications:
 //   - priority queues
 //   - k-way merge
+//   - top-k selection
 //   - shortest path first algorithms
 //   - etc.
 // 
@@ -24,6 +68,14 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <new>
+#include <iterator>
+#include <mutex>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 
@@ -31,125 +83,500 @@ using namespace std;
 #define MIN_HEAP    0
 #define MAX_HEAP    1   
 
-template<class T>
-class HeapTree {
-    int size;           // number of elements in the heap
-    int type;           // heap type: 0 = min; 1 = max; else = undefined
-    int kAry;           // number of chilren
+/* a k-ary heap ordered by the functor Compare,
+ *   compare(a, b) is true when a goes before b (closer to the root),
+ *   so less<T> makes a min-heap and greater<T> makes a max-heap.
+ *   K is the number of children known at compile time, the loops over
+ *   the children are unrolled and inlined by the compiler; K = 0 takes
+ *   the number of children at run time (kAry).
+ */
+template<class T, class Compare = less<T>, int K = 2>
+class Heap {
 protected:
+    int size;           // number of elements in the heap
+    int kAry;           // number of chilren, the same as K when K > 0
+    Compare compare;    // the order of the elements
     vector<T> heap;
-    void build_heap(const vector<T>& v);
+    void build_heap();
     void adjust_down(int i);
     void adjust_up(int i);
-public: 
-    HeapTree(const vector<T>& v) : size(v.size()), type(MAX_HEAP), kAry(2) { build_heap(v); };
-    HeapTree(const vector<T>& v, const int& t) : size(v.size()), type(t), kAry(2) { build_heap(v); }
-    HeapTree(const vector<T>& v, const int& t, const int& k) : size(v.size()), type(t), kAry(k) { build_heap(v); }
+public:
+    Heap() : Heap(vector<T>()) { }
+    Heap(const vector<T>& v, Compare c = Compare(), int k = K)     // copy the vector
+        : size(v.size()), kAry(K > 0 ? K : max(k, 1)), compare(c), heap(v) { build_heap(); }
+    Heap(vector<T>&& v, Compare c = Compare(), int k = K)          // take the vector over
+        : size(v.size()), kAry(K > 0 ? K : max(k, 1)), compare(c), heap(move(v)) { build_heap(); }
 
     int  get_size() { return size; };
-    int  get_type() { return type; };
+    const vector<T>& get_array() { return heap; }   // in the heap order, or sorted after sort()
+    const T& top() { return heap[0]; }
     T pop();
-    void push(T x);
+    void push(const T& x);
+    void push(T&& x);
+    template<class... Args> void emplace(Args&&... args);
+    template<class InputIt> void push_bulk(InputIt first, InputIt last);
     void sort();
     void display_heap_array(string title);
     void display_heap_tree();
 };
 
+/* the runtime heap type as a Compare functor of Heap.
+ */
+template<class T>
+struct HeapTypeCompare {
+    int type;           // heap type: 0 = min; 1 = max; else = undefined
+    HeapTypeCompare(int t = MAX_HEAP) : type(t) { }
+    bool operator()(const T& a, const T& b) const { 
+        return type == MIN_HEAP ? a < b : (type == MAX_HEAP && a > b); }
+};
+
+/* the heap with the type and the number of chilren given at run time.
+ */
+template<class T>
+struct HeapTree : public Heap<T, HeapTypeCompare<T>, 0> {
+    HeapTree(const vector<T>& v) : HeapTree(v, MAX_HEAP, 2) { }
+    HeapTree(const vector<T>& v, const int& t) : HeapTree(v, t, 2) { }
+    HeapTree(const vector<T>& v, const int& t, const int& k) 
+        : Heap<T, HeapTypeCompare<T>, 0>(v, HeapTypeCompare<T>(t), k) { }
+    HeapTree(vector<T>&& v) : HeapTree(move(v), MAX_HEAP, 2) { }
+    HeapTree(vector<T>&& v, const int& t) : HeapTree(move(v), t, 2) { }
+    HeapTree(vector<T>&& v, const int& t, const int& k) 
+        : Heap<T, HeapTypeCompare<T>, 0>(move(v), HeapTypeCompare<T>(t), k) { }
+
+    int  get_type() { return this->compare.type; };
+};
+
 template<class T>
 struct MinHeap : public HeapTree<T> {
     MinHeap(const vector<T>& v) : HeapTree<T>(v, MIN_HEAP) {}   // binary min-heap
     MinHeap(const vector<T>& v, const int& k) : HeapTree<T>(v, MIN_HEAP, k) {}  // k-ary min-heap
+    MinHeap(vector<T>&& v) : HeapTree<T>(move(v), MIN_HEAP) {}
+    MinHeap(vector<T>&& v, const int& k) : HeapTree<T>(move(v), MIN_HEAP, k) {}
 };
 
 template<class T>
 struct MaxHeap : public HeapTree<T> {
     MaxHeap(const vector<T>& v) : HeapTree<T>(v, MAX_HEAP) {}   // binary max-heap
     MaxHeap(const vector<T>& v, const int& k) : HeapTree<T>(v, MAX_HEAP, k) {}  // k-ary max-heap
+    MaxHeap(vector<T>&& v) : HeapTree<T>(move(v), MAX_HEAP) {}
+    MaxHeap(vector<T>&& v, const int& k) : HeapTree<T>(move(v), MAX_HEAP, k) {}
 };
 
-/* build_heap:
- *   copy a vector into the heap class, and
- *   turn it into a heap (tree).
+/* a binary min-max heap (double-ended priority queue).
+ *   stored in a vector the same as HeapTree, the root is heap[0], the
+ *   children of the node i are 2 * i + 1 and 2 * i + 2.
+ *   the levels 0, 2, 4 ... are min levels, 1, 3, 5 ... are max levels.
+ *   min() and max() are O(1), push(), pop_min() and pop_max() are O(log(n)).
+ */
+template<class T, class Compare = less<T>>
+class MinMaxHeap {
+    int  size;              // number of elements in the heap
+    Compare compare;        // the order, compare(a, b) is a < b
+    vector<T> heap;
+protected:
+    static bool min_level(int i) { return ((31 - __builtin_clz(i + 1)) & 1) == 0; }
+    bool before(int i, int j, bool is_min) { 
+        return is_min ? compare(heap[i], heap[j]) : compare(heap[j], heap[i]); }
+    int  max_index();
+    void adjust_down(int i);
+    void adjust_up(int i);
+public:
+    MinMaxHeap(Compare c = Compare()) : MinMaxHeap(vector<T>(), c) { }
+    MinMaxHeap(const vector<T>& v, Compare c = Compare()) : MinMaxHeap(vector<T>(v), c) { }
+    MinMaxHeap(vector<T>&& v, Compare c = Compare());
+
+    int  get_size() { return size; }
+    const T& min() { return heap[0]; }
+    const T& max() { return heap[max_index()]; }
+    void push(const T& x);
+    T    pop_min();
+    T    pop_max();
+};
+
+/* an indexed k-ary heap of the handles 0..n-1 ordered by their keys.
+ *   heap[] keeps the handles in the heap order,
+ *   position[h] is the index of the handle h in heap[], -1 if not in.
+ *   the type (MIN_HEAP, MAX_HEAP) and kAry are the same as HeapTree.
  */
 template<class T>
-void HeapTree<T>::build_heap(const vector<T>& v)
-{
-    int sz = size;
-    if (sz <= 1) {
-        return;
-    }
-    heap = v;
+class IndexedHeap {
+    int size;               // number of handles in the heap
+    int type;               // heap type: 0 = min; 1 = max
+    int kAry;               // number of chilren
+protected:
+    vector<int> heap;       // the handles
+    vector<T>   keys;       // the key of every handle
+    vector<int> position;   // the index of every handle in heap[]
+    bool before(int h1, int h2) { 
+        return type == MIN_HEAP ? keys[h1] < keys[h2] : keys[h1] > keys[h2]; }
+    void adjust_down(int i);
+    void adjust_up(int i);
+    void adjust(int i) { adjust_up(i); adjust_down(position[heap[i]]); }
+public:
+    IndexedHeap(int n) : IndexedHeap(n, MIN_HEAP, 2) { }
+    IndexedHeap(int n, const int& t) : IndexedHeap(n, t, 2) { }
+    IndexedHeap(int n, const int& t, const int& k) : size(0), type(t), kAry(max(k, 2)), 
+                                                     keys(n), position(n, -1) { heap.reserve(n); }
 
-    for (int i = sz/kAry - 1; i >= 0; --i) {
-        adjust_down(i);
-    }
-}
-/* adjust_down:
- *   adjust an array to a heap using recursion,
- *   starting from node i and going downward.
+    int  get_size() { return size; }
+    int  get_type() { return type; }
+    bool contains(int h) { return position[h] >= 0; }
+    T    get_key(int h) { return keys[h]; }
+    int  top() { return heap[0]; }
+    int  pop();
+    void push(int h, T key);
+    void erase(int h);
+    void decrease_key(int h, T key);
+    void increase_key(int h, T key);
+    void update_key(int h, T key);
+};
+
+/* a pairing heap, a heap ordered multiway tree which can be melded.
+ *   every node keeps its first child and its next sibling, the children
+ *   of a node are in a list. the nodes are allocated in blocks from a
+ *   node pool, the freed nodes are kept in a free list for the next push.
+ *   meld() takes all the nodes and the blocks of the other heap, so two
+ *   heaps are melded in O(1) without copying any element: the lists of
+ *   the blocks and of the free nodes are spliced by their tail pointers,
+ *   the unused range of the last block of the other heap is kept as a
+ *   spare range, new_node() takes its nodes later.
  */
+template<class T, class Compare = less<T>>
+class PairingHeap {
+    struct Node {
+        T     data;
+        Node* child;        // the first child
+        Node* sibling;      // the next sibling
+        Node(const T& x) : data(x), child(nullptr), sibling(nullptr) { }
+        Node(T&& x) : data(move(x)), child(nullptr), sibling(nullptr) { }
+    };
+    // the raw storage of a free node, of the first node of a block (the
+    // block header) or of an unused range, it holds no Node, only the links
+    struct RawLink {
+        Node* next;         // the next in the list
+        Node* end;          // the end of an unused range
+    };
+    int   size;             // number of elements in the heap
+    Node* root;
+    Compare compare;        // the order of the elements
+    Node* blocks;           // the node pool, a list of blocks
+    Node* blocks_tail;
+    Node* free_list;        // the released nodes
+    Node* free_tail;
+    Node* spare;            // the unused ranges of the blocks taken by meld()
+    Node* spare_tail;
+    Node* next_node;        // the unused range [next_node, end_node) of the last block
+    Node* end_node;
+    int   block_size;       // number of nodes of the last block
+protected:
+    template<class U> Node* new_node(U&& x);
+    void  delete_node(Node* p);
+    // the lists of the raw storage, a tail pointer splices two lists in O(1)
+    static RawLink* raw_link(Node* p) { return launder(reinterpret_cast<RawLink*>(p)); }
+    static void  raw_push(Node*& head, Node*& tail, Node* p, Node* end = nullptr);
+    static Node* raw_pop(Node*& head, Node*& tail);
+    static void  raw_splice(Node*& head, Node*& tail, Node*& other_head, Node*& other_tail);
+    Node* link(Node* a, Node* b);
+    Node* merge_pairs(Node* first);
+public:
+    PairingHeap(Compare c = Compare()) : size(0), root(nullptr), compare(c),
+        blocks(nullptr), blocks_tail(nullptr), free_list(nullptr), free_tail(nullptr),
+        spare(nullptr), spare_tail(nullptr), next_node(nullptr), end_node(nullptr), block_size(0) { }
+    PairingHeap(const PairingHeap&) = delete;
+    PairingHeap& operator=(const PairingHeap&) = delete;
+    ~PairingHeap();
+
+    int  get_size() { return size; }
+    T    top() { return root->data; }
+    T    pop();
+    void push(const T& x) { root = root ? link(root, new_node(x)) : new_node(x); ++size; }
+    void push(T&& x) { root = root ? link(root, new_node(move(x))) : new_node(move(x)); ++size; }
+    void meld(PairingHeap& other);
+};
+
+/* a loser tree of k sources, every source has a key (the head of a run).
+ *   tree[0] is the source of the winner, tree[1..k-1] are the losers of
+ *   the games, source i is the leaf k + i. a source is done when its run
+ *   is empty, it loses all the games. the ties are won by the lower source,
+ *   so a merge is stable.
+ */
+template<class T, class Compare = less<T>>
+class LoserTree {
+    int  k;                 // number of sources
+    Compare compare;        // the order of the keys
+    vector<T>    keys;      // the current key of every source
+    vector<char> done;      // the source has no more key
+    vector<int>  tree;      // the winner and the losers
+protected:
+    // one comparison: the lower source wins unless the other is less
+    bool beats(int a, int b) {
+        if (done[a] || done[b]) return !done[a] && (done[b] || a < b);
+        return a < b ? !compare(keys[b], keys[a]) : compare(keys[a], keys[b]); }
+    void replay(int i);
+public:
+    LoserTree(int n, Compare c = Compare()) : k(max(n, 1)), compare(c), 
+                                              keys(k), done(k, 1), tree(k, 0) { }
+
+    int  get_size() { return k; }
+    void set(int i, const T& key) { keys[i] = key; done[i] = 0; }   // before build()
+    void build();
+    bool empty() { return done[tree[0]]; }
+    int  top() { return tree[0]; }
+    const T& top_key() { return keys[tree[0]]; }
+    void replace_top(const T& key) { keys[tree[0]] = key; replay(tree[0]); }
+    void pop() { done[tree[0]] = 1; replay(tree[0]); }
+};
+
+/* a concurrent priority queue of shards, each a Heap with a lock.
+ *   push:  lock a random shard, push the element into it.
+ *   pop:   lock two random shards, pop the better one of their roots
+ *          (the two-choice pop), the shards are taken by try_lock,
+ *          a busy shard is skipped. after 2 * number_shards tries
+ *          without an element, pop locks (blocking) the shards one by
+ *          one to find the few elements left, only then it waits on a
+ *          lock.
+ * relaxed order:
+ *   pop doesn't always return the best element of the whole queue, but
+ *   one of the best elements, in average within O(number of shards)
+ *   ranks of the best; the elements pushed by one thread are not popped
+ *   in the order of the priority across the threads. no element is lost
+ *   or popped twice. pop returns false when the queue is seen empty,
+ *   an element pushed by another thread at the same time may be missed.
+ *   use about 2-4 shards per thread.
+ */
+template<class T, class Compare = less<T>, int K = 4>
+class MultiQueue {
+    struct alignas(64) Shard {
+        mutex lock;
+        Heap<T, Compare, K> heap;
+    };
+    int  number_shards;
+    Compare compare;
+    vector<Shard> shards;
+    atomic<long>  count;    // number of elements in all the shards
+protected:
+    int  random_shard();
+public:
+    MultiQueue(int n, Compare c = Compare()) : number_shards(max(n, 1)), compare(c), 
+                                               shards(number_shards), count(0) { }
+
+    long get_size() { return count.load(memory_order_relaxed); }
+    int  get_shards() { return number_shards; }
+    void push(const T& x);
+    bool pop(T& x);
+};
+
+/* a bounded top-k collector of a stream, given in batches or one by one.
+ *   keeps the k elements which go last in the Compare order, so the k
+ *   largest elements with less<T>, or the k smallest with greater<T>.
+ *   heap[] is a k-ary heap (K) in place, the root is the first to drop.
+ */
+template<class T, class Compare = less<T>, int K = 4>
+class TopK {
+    static_assert(K > 0, "the arity of TopK is a compile time K > 0");
+    int  k;                 // number of elements to keep
+    Compare compare;        // the order of the elements
+    vector<T> heap;
+public:
+    TopK(int n, Compare c = Compare()) : k(max(n, 0)), compare(c) { heap.reserve(k); }
+
+    int  get_size() { return heap.size(); }
+    const T& threshold() { return heap[0]; }    // the k-th element, when k are kept
+    void push(const T& x);
+    template<class InputIt> void push_batch(InputIt first, InputIt last);
+    vector<T> result();
+};
+
+/* an allocator of the memory aligned to the cache lines.
+ */
+#define CACHE_LINE  64
 template<class T>
-void HeapTree<T>::adjust_down(int i) 
-{ 
-    if (i < 0 || size <= 1 || kAry < 1) {
-        return;
-    }
+struct CacheLineAllocator {
+    typedef T value_type;
+    CacheLineAllocator() { }
+    template<class U> CacheLineAllocator(const CacheLineAllocator<U>&) { }
+    T*   allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(CACHE_LINE))); }
+    void deallocate(T* p, size_t) { ::operator delete(p, align_val_t(CACHE_LINE)); }
+    template<class U> bool operator==(const CacheLineAllocator<U>&) const { return true; }
+    template<class U> bool operator!=(const CacheLineAllocator<U>&) const { return false; }
+};
 
-    int  mm_index = i;
-    T mm_child = heap[i];
+/* a k-ary heap with the children of every node in one cache line.
+ *   kAry is the number of elements in a cache line (at least 2),
+ *   storage[] starts at a cache line, the heap starts at storage[kAry - 1],
+ *   so the children kAry * i + 1 .. kAry * i + kAry of the node i are at
+ *   storage[kAry * (i + 1) ..], the beginning of a cache line, when
+ *   sizeof(T) divides CACHE_LINE. for the other sizes the groups of
+ *   children drift across the lines, the heap is still correct but a
+ *   group may take two lines.
+ *   T must be default constructible for the kAry - 1 unused elements.
+ */
+template<class T, class Compare = less<T>>
+class CacheAlignedHeap {
+public:
+    static constexpr int kAry = sizeof(T) * 2 <= CACHE_LINE ? CACHE_LINE / sizeof(T) : 2;
+private:
+    int  size;              // number of elements in the heap
+    Compare compare;        // the order of the elements
+    vector<T, CacheLineAllocator<T>> storage;
+    T*   heap() { return storage.data() + kAry - 1; }
+public:
+    CacheAlignedHeap(Compare c = Compare()) : size(0), compare(c), storage(kAry - 1) { }
 
-    for (int m = 1; m <= kAry; ++m) {  
-        int child_index = kAry * i + m;
-        if (child_index >= size) {
+    int  get_size() { return size; }
+    void reserve(int n) { storage.reserve(n + kAry - 1); }
+    const T& top() { return heap()[0]; }
+    T    pop();
+    void push(const T& x);
+};
+
+/* heap_adjust_down:
+ *   adjust an array a[0..size) to a heap starting from node i and going downward.
+ * algorithm:
+ *   move the element at i out and leave a hole at i,
+ *   move the first child up into the hole while it goes before the element,
+ *   move the element into the hole at last.
+ *   one move per level instead of a swap (three moves).
+ */
+template<int K, class T, class Compare>
+void heap_adjust_down(T* a, int size, int i, int kAry, Compare& compare) 
+{ 
+    const int k = K > 0 ? K : kAry;
+    T x = move(a[i]);
+    while (true) {
+        int child = k * i + 1;
+        if (child >= size) {
             break;
         }
-        if ( ((type == MIN_HEAP) && (heap[child_index] < mm_child)) ||  
-             ((type == MAX_HEAP) && (heap[child_index] > mm_child)) ) 
-        {
-            mm_index = child_index;
-            mm_child = heap[child_index];
+        int first = child;
+        int last_child = min(child + k, size);
+        for (++child; child < last_child; ++child) {  
+            if (compare(a[child], a[first])) {
+                first = child;
+            }
         }
+        if (!compare(a[first], x)) {
+            break;
+        }
+        a[i] = move(a[first]);
+        i = first;
     }
-
-    if ( ((type == MIN_HEAP) && (heap[i] > heap[mm_index])) ||  
-         ((type == MAX_HEAP) && (heap[i] < heap[mm_index])) ) 
-    {
-        swap(heap[i], heap[mm_index]);
-        adjust_down(mm_index);
-    }
+    a[i] = move(x);
 } 
-/* adjust_up:
- *   adjust an arry to be a heap recursively,
- *   starting from node i and going upward.
+/* heap_adjust_up:
+ *   adjust an arry to be a heap starting from node i and going upward,
+ *   move the parents down into the hole the same as heap_adjust_down.
  */
-template<class T>
-void HeapTree<T>::adjust_up(int i) 
+template<int K, class T, class Compare>
+void heap_adjust_up(T* a, int i, int kAry, Compare& compare) 
 { 
-    if (i < 0 || size <= 1 || kAry < 1) {
+    const int k = K > 0 ? K : kAry;
+    T x = move(a[i]);
+    while (i > 0) {
+        int parent = (i - 1) / k;
+        if (!compare(x, a[parent])) {
+            break;
+        }
+        a[i] = move(a[parent]);
+        i = parent;
+    }
+    a[i] = move(x);
+}
+/* heap_make, heap_push, heap_pop:
+ *   the k-ary heap in place over an array a[0..n) owned by the caller,
+ *   nothing is copied or allocated, e.g. a heap over a huge buffer.
+ *   heap_make:  turn the array into a heap (Floyd, bottom up), O(n).
+ *   heap_push:  a[n-1] is the new element, a[0..n-1) is a heap.
+ *   heap_pop:   move the root to a[n-1], a[0..n-1) is the heap left.
+ *   K == 0 takes kAry at run time, at least 1, the same as Heap.
+ */
+template<int K = 2, class T, class Compare = less<T>>
+void heap_make(T* a, int n, Compare compare = Compare(), int kAry = K)
+{
+    const int k = K > 0 ? K : max(kAry, 1);
+    for (int i = (n - 2) / k; n > 1 && i >= 0; --i) {
+        heap_adjust_down<K>(a, n, i, k, compare);
+    }
+}
+template<int K = 2, class T, class Compare = less<T>>
+void heap_push(T* a, int n, Compare compare = Compare(), int kAry = K)
+{
+    if (n > 1) {
+        heap_adjust_up<K>(a, n - 1, K > 0 ? K : max(kAry, 1), compare);
+    }
+}
+template<int K = 2, class T, class Compare = less<T>>
+void heap_pop(T* a, int n, Compare compare = Compare(), int kAry = K)
+{
+    if (n > 1) {
+        swap(a[0], a[n - 1]);
+        heap_adjust_down<K>(a, n - 1, 0, K > 0 ? K : max(kAry, 1), compare);
+    }
+}
+/* build_heap:
+ *   turn the vector of the heap class into a heap (tree).
+ */
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::build_heap()
+{
+    heap_make<K>(heap.data(), size, compare, kAry);
+}
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::adjust_down(int i) 
+{ 
+    if (i >= 0 && size > 1) {
+        heap_adjust_down<K>(heap.data(), size, i, kAry, compare);
+    }
+}
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::adjust_up(int i) 
+{ 
+    if (i > 0 && size > 1) {
+        heap_adjust_up<K>(heap.data(), i, kAry, compare);
+    }
+}
+/* push_bulk:
+ *   append a batch of m elements to the heap of n elements.
+ * algorithm:
+ *   m sift-ups cost up to m * log_k(n + m) moves, Floyd's heapify of
+ *   the whole array costs about n + m, so the batch is pushed one by one
+ *   when it is small, or appended and re-heapified when it is large.
+ *   pass move_iterator to move the elements instead of copying them.
+ */
+template<class T, class Compare, int K>
+template<class InputIt>
+void Heap<T, Compare, K>::push_bulk(InputIt first, InputIt last)
+{
+    int n = size;
+    heap.insert(heap.end(), first, last);
+    size = heap.size();
+    const int m = size - n;
+    const int k = K > 0 ? K : kAry;
+
+    if ((double)m * (log(size) / log(max(k, 2))) > size) {
+        build_heap();
         return;
     }
-    int parent = (i - 1) / kAry;
-    if ( ((type == MIN_HEAP) && (heap[i] < heap[parent])) ||  
-         ((type == MAX_HEAP) && (heap[i] > heap[parent])) ) 
-    {
-        swap(heap[i], heap[parent]);
-        adjust_up(parent);
-    } 
+    for (int i = n; i < size; ++i) {
+        adjust_up(i);
+    }
 }
 /* pop:
  *   remove and return the root (max or min) element.
  * algorithm: 
- *   save the root;
+ *   move the root out;
  *   move the last element to the root;
  *   adjust the heap top-down;
  *   return the root;
  */
-template<class T>
-T HeapTree<T>::pop()
+template<class T, class Compare, int K>
+T Heap<T, Compare, K>::pop()
 {
-    T root = heap[0];
+    T root = move(heap[0]);
     --size;
-    heap[0] = heap[size];
+    if (size > 0) {
+        heap[0] = move(heap[size]);
+    }
     heap.pop_back();
     adjust_down(0);
     return root;
@@ -159,14 +586,30 @@ T HeapTree<T>::pop()
  * algorithm:
  *   add the new element at the end of the heap.
  *   adjust the heap from bottom up.
+ *   the element is copied, moved, or constructed in place (emplace).
  */
-template<class T>
-void HeapTree<T>::push(T x)
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::push(const T& x)
 {
     heap.push_back(x);
     ++size;
     adjust_up(size - 1);
 }
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::push(T&& x)
+{
+    heap.push_back(move(x));
+    ++size;
+    adjust_up(size - 1);
+}
+template<class T, class Compare, int K>
+template<class... Args>
+void Heap<T, Compare, K>::emplace(Args&&... args)
+{
+    heap.emplace_back(forward<Args>(args)...);
+    ++size;
+    adjust_up(size - 1);
+}
 /* sort:
  *   sorting the vector in asending order using max-heap or 
  *   desending order using min-heap.
@@ -177,8 +620,8 @@ void HeapTree<T>::push(T x)
  *   repeat the previous steps until only one element left,
  *   restore the size of the heap.
  */
-template<class T>
-void HeapTree<T>::sort()
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::sort()
 {
     int sz = size;
     for (int i = sz - 1; i >= 1; i--) {
@@ -188,14 +631,680 @@ void HeapTree<T>::sort()
     }
     size = sz;
 }
+/* IndexedHeap::adjust_down:
+ *   move the handle at i down until no child comes before it,
+ *   and keep the position map updated.
+ */
+template<class T>
+void IndexedHeap<T>::adjust_down(int i)
+{
+    while (true) {
+        int first = i;
+        int last_child = min(kAry * i + kAry, size - 1);
+        for (int child = kAry * i + 1; child <= last_child; ++child) {
+            if (before(heap[child], heap[first])) {
+                first = child;
+            }
+        }
+        if (first == i) {
+            break;
+        }
+        swap(heap[i], heap[first]);
+        position[heap[i]] = i;
+        position[heap[first]] = first;
+        i = first;
+    }
+}
+/* IndexedHeap::adjust_up:
+ *   move the handle at i up until it does not come before its parent.
+ */
+template<class T>
+void IndexedHeap<T>::adjust_up(int i)
+{
+    while (i > 0) {
+        int parent = (i - 1) / kAry;
+        if ( !before(heap[i], heap[parent]) ) {
+            break;
+        }
+        swap(heap[i], heap[parent]);
+        position[heap[i]] = i;
+        position[heap[parent]] = parent;
+        i = parent;
+    }
+}
+/* IndexedHeap::pop:
+ *   remove and return the handle at the root (min or max key),
+ *   its key is still available by get_key().
+ */
+template<class T>
+int IndexedHeap<T>::pop()
+{
+    int h = heap[0];
+    erase(h);
+    return h;
+}
+/* IndexedHeap::push:
+ *   add the handle h with the key, h must not be in the heap.
+ */
+template<class T>
+void IndexedHeap<T>::push(int h, T key)
+{
+    keys[h] = key;
+    heap.push_back(h);
+    position[h] = size++;
+    adjust_up(size - 1);
+}
+/* IndexedHeap::erase:
+ *   remove the handle h from the heap,
+ * algorithm:
+ *   move the last handle to the place of h,
+ *   adjust it upward or downward, its key could be either way.
+ */
+template<class T>
+void IndexedHeap<T>::erase(int h)
+{
+    int i = position[h];
+    if (i < 0) {
+        return;
+    }
+    --size;
+    heap[i] = heap[size];
+    position[heap[i]] = i;
+    heap.pop_back();
+    position[h] = -1;
+    if (i < size) {
+        adjust(i);
+    }
+}
+/* IndexedHeap::decrease_key:
+ *   lower the key of the handle h in the heap,
+ *   it moves up in a min-heap, down in a max-heap.
+ *   push h if it is not in the heap (erased or never pushed).
+ */
+template<class T>
+void IndexedHeap<T>::decrease_key(int h, T key)
+{
+    if ( !contains(h) ) {
+        push(h, key);
+        return;
+    }
+    keys[h] = key;
+    type == MIN_HEAP ? adjust_up(position[h]) : adjust_down(position[h]);
+}
+/* IndexedHeap::increase_key:
+ *   raise the key of the handle h in the heap,
+ *   it moves down in a min-heap, up in a max-heap.
+ *   push h if it is not in the heap (erased or never pushed).
+ */
+template<class T>
+void IndexedHeap<T>::increase_key(int h, T key)
+{
+    if ( !contains(h) ) {
+        push(h, key);
+        return;
+    }
+    keys[h] = key;
+    type == MIN_HEAP ? adjust_down(position[h]) : adjust_up(position[h]);
+}
+/* IndexedHeap::update_key:
+ *   change the key of the handle h, push h if not in the heap.
+ */
+template<class T>
+void IndexedHeap<T>::update_key(int h, T key)
+{
+    if ( !contains(h) ) {
+        push(h, key);
+        return;
+    }
+    keys[h] = key;
+    adjust(position[h]);
+}
+/* PairingHeap::raw_push, raw_pop, raw_splice:
+ *   the lists linked in the raw storage of the nodes (see RawLink).
+ */
+template<class T, class Compare>
+void PairingHeap<T, Compare>::raw_push(Node*& head, Node*& tail, Node* p, Node* end)
+{
+    ::new (static_cast<void*>(p)) RawLink{ head, end };
+    if (tail == nullptr) {
+        tail = p;
+    }
+    head = p;
+}
+template<class T, class Compare>
+typename PairingHeap<T, Compare>::Node* PairingHeap<T, Compare>::raw_pop(Node*& head, Node*& tail)
+{
+    Node* p = head;
+    head = raw_link(p)->next;
+    if (head == nullptr) {
+        tail = nullptr;
+    }
+    return p;
+}
+template<class T, class Compare>
+void PairingHeap<T, Compare>::raw_splice(Node*& head, Node*& tail, Node*& other_head, Node*& other_tail)
+{
+    if (other_head == nullptr) {
+        return;
+    }
+    raw_link(other_tail)->next = head;
+    if (tail == nullptr) {
+        tail = other_tail;
+    }
+    head = other_head;
+    other_head = other_tail = nullptr;
+}
+/* PairingHeap::new_node:
+ *   take a node from the free list, or from the unused range of the last
+ *   block, or from a spare range, add a new block (twice the size of the
+ *   last one) when there is none.
+ */
+template<class T, class Compare>
+template<class U>
+typename PairingHeap<T, Compare>::Node* PairingHeap<T, Compare>::new_node(U&& x)
+{
+    Node* p;
+    if (free_list != nullptr) {
+        p = raw_pop(free_list, free_tail);
+    }
+    else {
+        if (next_node == end_node) {
+            if (spare != nullptr) {
+                end_node = raw_link(spare)->end;
+                next_node = raw_pop(spare, spare_tail);
+            }
+            else {
+                // the first node of a block is its header in the block list
+                block_size = max(64, block_size * 2);
+                Node* b = static_cast<Node*>(::operator new(sizeof(Node) * (block_size + 1)));
+                raw_push(blocks, blocks_tail, b);
+                next_node = b + 1;
+                end_node = b + 1 + block_size;
+            }
+        }
+        p = next_node++;
+    }
+    return new (p) Node(forward<U>(x));
+}
+/* PairingHeap::delete_node:
+ *   destroy the element and put the node into the free list.
+ */
+template<class T, class Compare>
+void PairingHeap<T, Compare>::delete_node(Node* p)
+{
+    p->~Node();
+    raw_push(free_list, free_tail, p);
+}
+/* PairingHeap::link:
+ *   link two trees, the root which goes after becomes the first child of the other.
+ */
+template<class T, class Compare>
+typename PairingHeap<T, Compare>::Node* PairingHeap<T, Compare>::link(Node* a, Node* b)
+{
+    if (compare(b->data, a->data)) {
+        swap(a, b);
+    }
+    b->sibling = a->child;
+    a->child = b;
+    return a;
+}
+/* PairingHeap::merge_pairs:
+ *   merge a list of siblings into one tree.
+ * algorithm (two pass):
+ *   link the siblings in pairs from left to right,
+ *   then link the pairs from right to left into one tree.
+ *   the pairs are kept in a reversed list, no recursion.
+ */
+template<class T, class Compare>
+typename PairingHeap<T, Compare>::Node* PairingHeap<T, Compare>::merge_pairs(Node* first)
+{
+    Node* pairs = nullptr;
+    while (first != nullptr) {
+        Node* a = first;
+        Node* b = a->sibling;
+        if (b == nullptr) {
+            a->sibling = pairs;
+            pairs = a;
+            break;
+        }
+        first = b->sibling;
+        a->sibling = b->sibling = nullptr;
+        a = link(a, b);
+        a->sibling = pairs;
+        pairs = a;
+    }
+
+    Node* tree = nullptr;
+    while (pairs != nullptr) {
+        Node* next = pairs->sibling;
+        pairs->sibling = nullptr;
+        tree = tree ? link(tree, pairs) : pairs;
+        pairs = next;
+    }
+    return tree;
+}
+/* PairingHeap::pop:
+ *   remove and return the root, merge its children to be the new root.
+ */
+template<class T, class Compare>
+T PairingHeap<T, Compare>::pop()
+{
+    Node* p = root;
+    T x = move(p->data);
+    root = merge_pairs(p->child);
+    delete_node(p);
+    --size;
+    return x;
+}
+/* PairingHeap::meld:
+ *   move all the elements of the other heap into this one,
+ *   link the two roots and take over the node pool of the other heap.
+ *   the other heap is empty after meld.
+ */
+template<class T, class Compare>
+void PairingHeap<T, Compare>::meld(PairingHeap& other)
+{
+    if (this == &other) {
+        return;
+    }
+    if (other.root != nullptr) {
+        root = root ? link(root, other.root) : other.root;
+    }
+    size += other.size;
+
+    // the blocks, the free nodes and the unused ranges of the other heap
+    raw_splice(blocks, blocks_tail, other.blocks, other.blocks_tail);
+    raw_splice(free_list, free_tail, other.free_list, other.free_tail);
+    raw_splice(spare, spare_tail, other.spare, other.spare_tail);
+    if (other.next_node != other.end_node) {
+        raw_push(spare, spare_tail, other.next_node, other.end_node);
+    }
+    block_size = max(block_size, other.block_size);
+
+    other.root = nullptr;
+    other.size = 0;
+    other.next_node = other.end_node = nullptr;
+    other.block_size = 0;
+}
+/* PairingHeap::~PairingHeap:
+ *   destroy the elements left in the heap, then release the node pool.
+ */
+template<class T, class Compare>
+PairingHeap<T, Compare>::~PairingHeap()
+{
+    vector<Node*> stack;
+    if (root != nullptr) {
+        stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        Node* p = stack.back();
+        stack.pop_back();
+        if (p->child)   stack.push_back(p->child);
+        if (p->sibling) stack.push_back(p->sibling);
+        p->~Node();
+    }
+    while (blocks != nullptr) {
+        ::operator delete(raw_pop(blocks, blocks_tail));
+    }
+}
+/* LoserTree::build:
+ *   play all the games bottom up, keep the losers in the tree.
+ */
+template<class T, class Compare>
+void LoserTree<T, Compare>::build()
+{
+    vector<int> winner(2 * k);
+    for (int i = 0; i < k; ++i) {
+        winner[k + i] = i;
+    }
+    for (int n = k - 1; n >= 1; --n) {
+        int a = winner[2 * n], b = winner[2 * n + 1];
+        if (beats(a, b)) {
+            winner[n] = a;  tree[n] = b;
+        }
+        else {
+            winner[n] = b;  tree[n] = a;
+        }
+    }
+    tree[0] = winner[1];
+}
+/* LoserTree::replay:
+ *   the key of the source i has changed, replay the games from its leaf
+ *   up to the root, the new winner stays on the path, the loser is kept.
+ */
+template<class T, class Compare>
+void LoserTree<T, Compare>::replay(int i)
+{
+    int w = i;
+    for (int n = (k + i) / 2; n >= 1; n /= 2) {
+        if (beats(tree[n], w)) {
+            swap(tree[n], w);
+        }
+    }
+    tree[0] = w;
+}
+/* loser_tree_merge:
+ *   merge the k sorted runs [first, last) into the output in a stable order.
+ *   the runs can be any input iterators, e.g. pointers of arrays, or
+ *   istream_iterator of files, each element is read once.
+ *   return: the end of the output.
+ */
+template<class InputIt, class OutputIt, 
+         class Compare = less<typename iterator_traits<InputIt>::value_type>>
+OutputIt loser_tree_merge(vector<pair<InputIt, InputIt>> runs, OutputIt out, Compare c = Compare())
+{
+    LoserTree<typename iterator_traits<InputIt>::value_type, Compare> L(runs.size(), c);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].first != runs[i].second) {
+            L.set(i, *runs[i].first);
+        }
+    }
+    L.build();
+    while (!L.empty()) {
+        int i = L.top();
+        *out++ = L.top_key();
+        if (++runs[i].first != runs[i].second) {
+            L.replace_top(*runs[i].first);
+        }
+        else {
+            L.pop();
+        }
+    }
+    return out;
+}
+/* MultiQueue::random_shard:
+ *   a xorshift random number per thread, no shared state.
+ */
+template<class T, class Compare, int K>
+int MultiQueue<T, Compare, K>::random_shard()
+{
+    static thread_local unsigned long seed = 
+        hash<thread::id>()(this_thread::get_id()) | 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed % number_shards;
+}
+/* MultiQueue::push:
+ *   push the element into a random shard which is not locked.
+ */
+template<class T, class Compare, int K>
+void MultiQueue<T, Compare, K>::push(const T& x)
+{
+    while (true) {
+        Shard& s = shards[random_shard()];
+        if (s.lock.try_lock()) {
+            s.heap.push(x);
+            count.fetch_add(1, memory_order_release);
+            s.lock.unlock();
+            return;
+        }
+    }
+}
+/* MultiQueue::pop:
+ *   pop the better root of two random shards into x.
+ * algorithm:
+ *   try to lock two random shards, skip a shard which is locked,
+ *   pop the root which goes before the other, or the only one.
+ *   after many tries without an element, lock the shards one by one,
+ *   so a few elements left in a large queue are still found.
+ *   return: false when the queue is empty.
+ */
+template<class T, class Compare, int K>
+bool MultiQueue<T, Compare, K>::pop(T& x)
+{
+    for (int tries = 0; count.load(memory_order_acquire) > 0; ++tries) {
+        if (tries > 2 * number_shards) {
+            for (int i = 0; i < number_shards; ++i) {
+                lock_guard<mutex> guard(shards[i].lock);
+                if (shards[i].heap.get_size() > 0) {
+                    x = shards[i].heap.pop();
+                    count.fetch_sub(1, memory_order_relaxed);
+                    return true;
+                }
+            }
+            tries = 0;
+            continue;
+        }
+
+        Shard* a = &shards[random_shard()];
+        Shard* b = &shards[random_shard()];
+        if (!a->lock.try_lock()) {
+            continue;
+        }
+        if (a == b || !b->lock.try_lock()) {
+            b = nullptr;
+        }
+
+        Shard* best = a->heap.get_size() > 0 ? a : nullptr;
+        if (b != nullptr && b->heap.get_size() > 0 && 
+            (best == nullptr || compare(b->heap.top(), best->heap.top()))) {
+            best = b;
+        }
+        if (best != nullptr) {
+            x = best->heap.pop();
+            count.fetch_sub(1, memory_order_relaxed);
+        }
+        if (b != nullptr) {
+            b->lock.unlock();
+        }
+        a->lock.unlock();
+        if (best != nullptr) {
+            return true;
+        }
+    }
+    return false;
+}
+/* TopK::push:
+ *   keep x when less than k are kept, or x goes after the root,
+ *   then x replaces the root and goes down.
+ */
+template<class T, class Compare, int K>
+void TopK<T, Compare, K>::push(const T& x)
+{
+    if ((int)heap.size() < k) {
+        heap.push_back(x);
+        heap_push<K>(heap.data(), heap.size(), compare);
+    }
+    else if (k > 0 && compare(heap[0], x)) {
+        heap[0] = x;
+        heap_adjust_down<K>(heap.data(), k, 0, K, compare);
+    }
+}
+/* TopK::push_batch:
+ *   take a batch of the stream, fill the heap first and heapify it once,
+ *   the rest only compare with the root, most of them are dropped at once.
+ */
+template<class T, class Compare, int K>
+template<class InputIt>
+void TopK<T, Compare, K>::push_batch(InputIt first, InputIt last)
+{
+    if ((int)heap.size() < k) {
+        for (; first != last && (int)heap.size() < k; ++first) {
+            heap.push_back(*first);
+        }
+        heap_make<K>(heap.data(), heap.size(), compare);
+    }
+    for (; k > 0 && first != last; ++first) {
+        if (compare(heap[0], *first)) {
+            heap[0] = *first;
+            heap_adjust_down<K>(heap.data(), k, 0, K, compare);
+        }
+    }
+}
+/* TopK::result:
+ *   return the elements kept, the last in the Compare order first,
+ *   e.g. the largest first with less<T>.
+ */
+template<class T, class Compare, int K>
+vector<T> TopK<T, Compare, K>::result()
+{
+    vector<T> v(heap);
+    for (int n = v.size(); n > 1; --n) {
+        heap_pop<K>(v.data(), n, compare);
+    }
+    return v;
+}
+/* CacheAlignedHeap::pop, push:
+ *   the same as Heap, on the heap array shifted in the storage.
+ */
+template<class T, class Compare>
+T CacheAlignedHeap<T, Compare>::pop()
+{
+    T* a = heap();
+    T root = move(a[0]);
+    --size;
+    if (size > 0) {
+        a[0] = move(a[size]);
+    }
+    storage.pop_back();
+    if (size > 1) {
+        heap_adjust_down<kAry>(a, size, 0, kAry, compare);
+    }
+    return root;
+}
+template<class T, class Compare>
+void CacheAlignedHeap<T, Compare>::push(const T& x)
+{
+    storage.push_back(x);
+    ++size;
+    heap_adjust_up<kAry>(heap(), size - 1, kAry, compare);
+}
+/* MinMaxHeap::MinMaxHeap:
+ *   take the vector over and turn it into a min-max heap (bottom up).
+ */
+template<class T, class Compare>
+MinMaxHeap<T, Compare>::MinMaxHeap(vector<T>&& v, Compare c) : size(v.size()), compare(c), heap(move(v))
+{
+    for (int i = size / 2 - 1; i >= 0; --i) {
+        adjust_down(i);
+    }
+}
+/* MinMaxHeap::max_index:
+ *   the max is the root (one element), or one of the root's children.
+ */
+template<class T, class Compare>
+int MinMaxHeap<T, Compare>::max_index()
+{
+    if (size <= 2) {
+        return size - 1;
+    }
+    return compare(heap[1], heap[2]) ? 2 : 1;
+}
+/* MinMaxHeap::adjust_down:
+ *   move the node i down on the min levels (or the max levels).
+ * algorithm (on a min level):
+ *   find the smallest m of the children and grandchildren of i,
+ *   if m is a grandchild and less than i, swap them, and swap m with its
+ *   parent when m is greater than the parent (a max level), go on from m.
+ *   if m is a child and less than i, swap them and stop.
+ */
+template<class T, class Compare>
+void MinMaxHeap<T, Compare>::adjust_down(int i)
+{
+    const bool is_min = min_level(i);
+    while (2 * i + 1 < size) {
+        int m = 2 * i + 1;
+        int last = std::min(4 * i + 6, size - 1);   // min() is the member
+        for (int j = 2 * i + 2; j <= last; ++j) {
+            if (j == 2 * i + 3) {
+                j = 4 * i + 3;      // the first grandchild
+                if (j > last) break;
+            }
+            if (before(j, m, is_min)) {
+                m = j;
+            }
+        }
+        if (!before(m, i, is_min)) {
+            break;
+        }
+        swap(heap[m], heap[i]);
+        if (m <= 2 * i + 2) {       // a child
+            break;
+        }
+        int parent = (m - 1) / 2;
+        if (before(parent, m, is_min)) {
+            swap(heap[m], heap[parent]);
+        }
+        i = m;
+    }
+}
+/* MinMaxHeap::adjust_up:
+ *   move the node i up on the min levels or the max levels.
+ * algorithm:
+ *   on a min level, if i is greater than its parent (a max level),
+ *   swap them and go up on the max levels from the parent, otherwise
+ *   go up on the min levels (grandparents), and vice versa.
+ */
+template<class T, class Compare>
+void MinMaxHeap<T, Compare>::adjust_up(int i)
+{
+    if (i == 0) {
+        return;
+    }
+    bool is_min = min_level(i);
+    int parent = (i - 1) / 2;
+    if (before(parent, i, is_min)) {
+        swap(heap[i], heap[parent]);
+        i = parent;
+        is_min = !is_min;
+    }
+    while (i > 2) {
+        int grandparent = ((i - 1) / 2 - 1) / 2;
+        if (!before(i, grandparent, is_min)) {
+            break;
+        }
+        swap(heap[i], heap[grandparent]);
+        i = grandparent;
+    }
+}
+/* MinMaxHeap::push, pop_min, pop_max:
+ *   push adds the element at the end and adjusts it up,
+ *   pop moves the last element to the place of the min (or max)
+ *   and adjusts it down.
+ */
+template<class T, class Compare>
+void MinMaxHeap<T, Compare>::push(const T& x)
+{
+    heap.push_back(x);
+    ++size;
+    adjust_up(size - 1);
+}
+template<class T, class Compare>
+T MinMaxHeap<T, Compare>::pop_min()
+{
+    T x = move(heap[0]);
+    --size;
+    if (size > 0) {
+        heap[0] = move(heap[size]);
+    }
+    heap.pop_back();
+    adjust_down(0);
+    return x;
+}
+template<class T, class Compare>
+T MinMaxHeap<T, Compare>::pop_max()
+{
+    int i = max_index();
+    T x = move(heap[i]);
+    --size;
+    if (i < size) {
+        heap[i] = move(heap[size]);
+    }
+    heap.pop_back();
+    if (i < size) {
+        adjust_down(i);
+    }
+    return x;
+}
 /* display_heap_array:
  *    display the heap data in array format.
  * note:
  *    only display the data in the beginning and at the end,
  *    when the size of heap greater than 32.
  */
-template<class T>
-void HeapTree<T>::display_heap_array(string title)
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::display_heap_array(string title)
 {
     const int words_line = min(16, size);
     const int word_width = log10(size) + 2;
@@ -220,8 +1329,8 @@ void HeapTree<T>::display_heap_array(string title)
  *   display the heap data by tree levels.
  *   [p-c] shows the parent index and child index.
  */
-template<class T>
-void HeapTree<T>::display_heap_tree()
+template<class T, class Compare, int K>
+void Heap<T, Compare, K>::display_heap_tree()
 {
     if (size <= 0)  return;
 
@@ -235,9 +1344,456 @@ void HeapTree<T>::display_heap_tree()
         cout << endl;
     }
 }
+/* testing driver code,
+ *   define HEAP_LIBRARY before including this file to use the heaps
+ *   without the testing driver.
+ */
+#ifndef HEAP_LIBRARY
+#include <chrono>
+
+#define TESTING_HEAP(s, ...) { \
+    cout << "\e[1m" << s << "\e[0m" << ": "; \
+    auto start = chrono::high_resolution_clock::now(); \
+    __VA_ARGS__; \
+    auto end = chrono::high_resolution_clock::now(); \
+    cout << "Elapsed time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << " us"; \
+}
+/* heap_benchmark_push_pop:
+ *   push the n elements to an empty heap, then pop all of them.
+ */
+template<class H>
+long heap_benchmark_push_pop(H& Q, const vector<long>& v)
+{
+    long sum = 0;
+    for (size_t i = 0; i < v.size(); ++i) { Q.push(v[i]); }
+    while (Q.get_size() > 0) { sum += Q.pop() & 1; }
+    return sum;
+}
+/* heap_benchmark_arity:
+ *   compare the runtime type and k of HeapTree with the compile time
+ *   Compare and K of Heap, for the k = 2, 4, 8 min-heaps.
+ */
+void heap_benchmark_arity(int n)
+{
+    vector<long> v(n), empty;
+    for (int i = 0; i < n; ++i) { v[i] = rand(); }
+
+    const int arity[] = { 2, 4, 8 };
+    for (int k : arity) {
+        long sum = 0;
+        string title = "HeapTree<long>(MIN_HEAP, " + to_string(k) + ")    ";
+        TESTING_HEAP(title, {
+            HeapTree<long> Q(empty, MIN_HEAP, k);
+            sum = heap_benchmark_push_pop(Q, v);
+        });
+        cout << ", odd = " << sum << endl;
+    }
+    long sum = 0;
+    TESTING_HEAP("Heap<long, less<long>, 2>     ", {
+        Heap<long, less<long>, 2> Q;
+        sum = heap_benchmark_push_pop(Q, v);
+    });
+    cout << ", odd = " << sum << endl;
+    TESTING_HEAP("Heap<long, less<long>, 4>     ", {
+        Heap<long, less<long>, 4> Q;
+        sum = heap_benchmark_push_pop(Q, v);
+    });
+    cout << ", odd = " << sum << endl;
+    TESTING_HEAP("Heap<long, less<long>, 8>     ", {
+        Heap<long, less<long>, 8> Q;
+        sum = heap_benchmark_push_pop(Q, v);
+    });
+    cout << ", odd = " << sum << endl;
+}
+/* a heavy element type for the benchmarks, a priority with a payload.
+ */
+struct HeapTask {
+    long priority;
+    string name;
+    vector<long> payload;
+    HeapTask() : priority(0) { }
+    HeapTask(long p, const string& s, int n) : priority(p), name(s), payload(n, p) { }
+    bool operator<(const HeapTask& t) const { return priority < t.priority; }
+};
+/* heap_benchmark_moves:
+ *   push the n heavy elements (strings, tasks) to a 4-ary min-heap by
+ *   copy, by move and in place, then pop all of them.
+ */
+void heap_benchmark_moves(int n)
+{
+    vector<string> strings(n);
+    vector<long>   priority(n);
+    for (int i = 0; i < n; ++i) { 
+        priority[i] = rand();
+        strings[i] = "task-" + to_string(priority[i]) + string(32, 'x'); 
+    }
+
+    size_t sum = 0;
+    TESTING_HEAP("Heap<string> push copy     ", {
+        Heap<string, less<string>, 4> Q;
+        for (int i = 0; i < n; ++i) { Q.push(strings[i]); }
+        while (Q.get_size() > 0) { sum += Q.pop().size(); }
+    });
+    cout << ", length = " << sum << endl;
+    sum = 0;
+    TESTING_HEAP("Heap<string> push move     ", {
+        vector<string> w(strings);
+        Heap<string, less<string>, 4> Q;
+        for (int i = 0; i < n; ++i) { Q.push(move(w[i])); }
+        while (Q.get_size() > 0) { sum += Q.pop().size(); }
+    });
+    cout << ", length = " << sum << " (with a copy of the input)" << endl;
+
+    vector<HeapTask> tasks;
+    tasks.reserve(n);
+    for (int i = 0; i < n; ++i) { tasks.emplace_back(priority[i], strings[i], 16); }
+    sum = 0;
+    TESTING_HEAP("Heap<HeapTask> push copy   ", {
+        Heap<HeapTask, less<HeapTask>, 4> Q;
+        for (int i = 0; i < n; ++i) { Q.push(tasks[i]); }
+        while (Q.get_size() > 0) { sum += Q.pop().payload.size(); }
+    });
+    cout << ", payload = " << sum << endl;
+    sum = 0;
+    TESTING_HEAP("Heap<HeapTask> push move   ", {
+        vector<HeapTask> w(tasks);
+        Heap<HeapTask, less<HeapTask>, 4> Q;
+        for (int i = 0; i < n; ++i) { Q.push(move(w[i])); }
+        while (Q.get_size() > 0) { sum += Q.pop().payload.size(); }
+    });
+    cout << ", payload = " << sum << " (with a copy of the input)" << endl;
+    sum = 0;
+    TESTING_HEAP("Heap<HeapTask> emplace     ", {
+        Heap<HeapTask, less<HeapTask>, 4> Q;
+        for (int i = 0; i < n; ++i) { Q.emplace(priority[i], strings[i], 16); }
+        while (Q.get_size() > 0) { sum += Q.pop().payload.size(); }
+    });
+    cout << ", payload = " << sum << endl;
+}
+/* heap_benchmark_bulk:
+ *   build a heap of n elements by copy, by move and in place (heap_make),
+ *   then push a batch of elements one by one against push_bulk, for a
+ *   large batch (re-heapified) and a small batch (sift-ups).
+ */
+void heap_benchmark_bulk(int n)
+{
+    vector<long> v(n);
+    for (int i = 0; i < n; ++i) { v[i] = rand(); }
+
+    long root = 0;
+    TESTING_HEAP("Build by Copy (const vector&)   ", {
+        MinHeap<long> Q(v, 4);
+        root = Q.top();
+    });
+    cout << ", root = " << root << endl;
+    vector<long> w(v);
+    TESTING_HEAP("Build by Move (vector&&)        ", {
+        MinHeap<long> Q(move(w), 4);
+        root = Q.top();
+    });
+    cout << ", root = " << root << endl;
+    w = v;
+    TESTING_HEAP("Build in Place (heap_make)      ", {
+        heap_make<4>(w.data(), n, less<long>());
+        root = w[0];
+    });
+    cout << ", root = " << root << endl;
+
+    for (int batch : { n / 2, max(n / 1000, 1) }) {
+        vector<long> base(v.begin(), v.end() - batch);
+        TESTING_HEAP("Push " + to_string(batch) + " One by One      ", {
+            Heap<long, less<long>, 4> Q(base);
+            for (int i = n - batch; i < n; ++i) { Q.push(v[i]); }
+            root = Q.top();
+        });
+        cout << ", root = " << root << " (with the copy of " << base.size() << ")" << endl;
+        TESTING_HEAP("Push " + to_string(batch) + " Bulk            ", {
+            Heap<long, less<long>, 4> Q(base);
+            Q.push_bulk(v.end() - batch, v.end());
+            root = Q.top();
+        });
+        cout << ", root = " << root << " (with the copy of " << base.size() << ")" << endl;
+    }
+}
+/* heap_benchmark_topk:
+ *   the k largest of n elements, a full HeapTree::sort against the TopK
+ *   collector of the stream given in batches of 4096.
+ */
+void heap_benchmark_topk(int n, int k)
+{
+    vector<long> v(n);
+    for (int i = 0; i < n; ++i) { v[i] = rand(); }
+
+    long kth = 0;
+    TESTING_HEAP("Top-K by HeapTree::sort", {
+        MaxHeap<long> Q(v, 4);
+        Q.sort();
+        vector<long> top(Q.get_array().end() - k, Q.get_array().end());
+        kth = top[0];       // the max-heap is sorted in ascending order
+    });
+    cout << ", k = " << k << ", k-th = " << kth << endl;
+    TESTING_HEAP("Top-K by TopK          ", {
+        TopK<long> T(k);
+        for (int i = 0; i < n; i += 4096) {
+            T.push_batch(v.begin() + i, v.begin() + min(n, i + 4096));
+        }
+        kth = T.result().back();
+    });
+    cout << ", k = " << k << ", k-th = " << kth << endl;
+}
+/* heap_benchmark_layout:
+ *   a hold model on a heap of n elements: pop the root and push it back
+ *   with a later time, m times. the vector layout of Heap (k = 2 and 8)
+ *   against CacheAlignedHeap (k = 8 for long, one cache line per level).
+ *   the difference shows when the heap is larger than the caches,
+ *   10^7 elements and more (10^9 longs take 8 GB).
+ */
+template<class H>
+long heap_benchmark_hold(H& Q, const vector<long>& v, int m)
+{
+    for (size_t i = 0; i < v.size(); ++i) { Q.push(v[i]); }
+    long t = 0;
+    for (int j = 0; j < m; ++j) {
+        t = Q.pop();
+        Q.push(t + v[j % v.size()] % 1024 + 1);
+    }
+    return t;
+}
+void heap_benchmark_layout(int n, int m)
+{
+    vector<long> v(n);
+    for (int i = 0; i < n; ++i) { v[i] = rand(); }
+
+    long t = 0;
+    TESTING_HEAP("Hold (Heap k = 2)             ", {
+        Heap<long, less<long>, 2> Q;
+        t = heap_benchmark_hold(Q, v, m);
+    });
+    cout << ", n = " << n << ", time = " << t << endl;
+    TESTING_HEAP("Hold (Heap k = 8)             ", {
+        Heap<long, less<long>, 8> Q;
+        t = heap_benchmark_hold(Q, v, m);
+    });
+    cout << ", n = " << n << ", time = " << t << endl;
+    TESTING_HEAP("Hold (CacheAlignedHeap k = " + to_string(CacheAlignedHeap<long>::kAry) + ")", {
+        CacheAlignedHeap<long> Q;
+        t = heap_benchmark_hold(Q, v, m);
+    });
+    cout << ", n = " << n << ", time = " << t << endl;
+}
+/* heap_benchmark_meld:
+ *   a merge heavy workload, p per-thread priority queues of n/p elements
+ *   are combined pairwise (log2(p) rounds, popping a few elements after
+ *   each merge), then the last queue is drained. HeapTree re-pushes the
+ *   elements of one queue into the other, PairingHeap melds them.
+ */
+void heap_benchmark_meld(int n, int p)
+{
+    vector<long> v(n), empty;
+    for (int i = 0; i < n; ++i) { v[i] = rand(); }
+    const int m = n / p;
+
+    long sum = 0;
+    TESTING_HEAP("Re-push (HeapTree)   ", {
+        vector<MinHeap<long>> Q(p, MinHeap<long>(empty));
+        for (int i = 0; i < p * m; ++i) { Q[i % p].push(v[i]); }
+        for (int step = 1; step < p; step *= 2) {
+            for (int i = 0; i + step < p; i += 2 * step) {
+                while (Q[i + step].get_size() > 0) { Q[i].push(Q[i + step].pop()); }
+                for (int j = 0; j < 16 && Q[i].get_size() > 0; ++j) { sum += Q[i].pop() & 1; }
+            }
+        }
+        while (Q[0].get_size() > 0) { sum += Q[0].pop() & 1; }
+    });
+    cout << ", odd = " << sum << endl;
+
+    sum = 0;
+    TESTING_HEAP("Meld (PairingHeap)   ", {
+        vector<PairingHeap<long>> Q(p);
+        for (int i = 0; i < p * m; ++i) { Q[i % p].push(v[i]); }
+        for (int step = 1; step < p; step *= 2) {
+            for (int i = 0; i + step < p; i += 2 * step) {
+                Q[i].meld(Q[i + step]);
+                for (int j = 0; j < 16 && Q[i].get_size() > 0; ++j) { sum += Q[i].pop() & 1; }
+            }
+        }
+        while (Q[0].get_size() > 0) { sum += Q[0].pop() & 1; }
+    });
+    cout << ", odd = " << sum << endl;
+}
+/* heap_benchmark_kway:
+ *   merge k sorted runs of n elements in total, the loser tree against
+ *   a k-ary MinHeap of (key, run) pairs which pops and pushes every element.
+ */
+void heap_benchmark_kway(int n, int k)
+{
+    vector<long> v(n), out(n), empty;
+    for (int i = 0; i < n; ++i) { v[i] = rand(); }
+    const int m = n / k;
+    for (int r = 0; r < k; ++r) {
+        long* first = v.data() + r * m;
+        long* last = r == k - 1 ? v.data() + n : first + m;
+        MinHeap<long> H(vector<long>(first, last), 4);
+        for (long* p = first; p != last; ++p) { *p = H.pop(); }
+    }
+    vector<pair<long*, long*>> runs;
+    for (int r = 0; r < k; ++r) {
+        runs.push_back(make_pair(v.data() + r * m, r == k - 1 ? v.data() + n : v.data() + (r + 1) * m));
+    }
+
+    int  sorted = 0;
+    TESTING_HEAP("K-way Merge (MinHeap)   ", {
+        vector<pair<long, int>> entries;
+        MinHeap<pair<long, int>> Q(entries, 4);
+        vector<pair<long*, long*>> heads(runs);
+        for (int r = 0; r < k; ++r) { 
+            if (heads[r].first != heads[r].second) Q.push(make_pair(*heads[r].first++, r)); 
+        }
+        for (int i = 0; Q.get_size() > 0; ++i) {
+            auto e = Q.pop();
+            out[i] = e.first;
+            if (heads[e.second].first != heads[e.second].second) {
+                Q.push(make_pair(*heads[e.second].first++, e.second));
+            }
+        }
+    });
+    for (int i = 1; i < n; ++i) { sorted += out[i - 1] <= out[i]; }
+    cout << ", k = " << k << ", sorted = " << sorted + 1 << endl;
+
+    sorted = 0;
+    TESTING_HEAP("K-way Merge (LoserTree) ", {
+        loser_tree_merge(runs, out.begin());
+    });
+    for (int i = 1; i < n; ++i) { sorted += out[i - 1] <= out[i]; }
+    cout << ", k = " << k << ", sorted = " << sorted + 1 << endl;
+}
+/* heap_benchmark_concurrent:
+ *   p threads push and pop m elements each (alternately) on a queue
+ *   prefilled with n elements, a Heap behind one mutex against a
+ *   MultiQueue of 4 shards per thread, for 1, 2, 4 ... max_threads.
+ */
+void heap_benchmark_concurrent(int n, int m, int max_threads)
+{
+    for (int p = 1; p <= max_threads; p *= 2) {
+        long popped = 0;
+        TESTING_HEAP("Locked Heap, threads = " + to_string(p) + "   ", {
+            mutex lock;
+            Heap<long, less<long>, 4> Q;
+            for (int i = 0; i < n; ++i) { Q.push(rand()); }
+            atomic<long> total(0);
+            vector<thread> workers;
+            for (int t = 0; t < p; ++t) {
+                workers.emplace_back([&, t]() {
+                    long got = 0;
+                    uint64_t seed = t + 1;
+                    for (int i = 0; i < m; ++i) {
+                        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                        lock_guard<mutex> guard(lock);
+                        if (i & 1) { 
+                            if (Q.get_size() > 0) { Q.pop(); ++got; }
+                        }
+                        else {
+                            Q.push((long)(seed >> 33));
+                        }
+                    }
+                    total += got;
+                });
+            }
+            for (auto& w : workers) { w.join(); }
+            popped = total;
+        });
+        cout << ", popped = " << popped << endl;
+
+        TESTING_HEAP("MultiQueue, threads = " + to_string(p) + "    ", {
+            MultiQueue<long, less<long>, 4> Q(4 * p);
+            for (int i = 0; i < n; ++i) { Q.push(rand()); }
+            atomic<long> total(0);
+            vector<thread> workers;
+            for (int t = 0; t < p; ++t) {
+                workers.emplace_back([&, t]() {
+                    long x, got = 0;
+                    uint64_t seed = t + 1;
+                    for (int i = 0; i < m; ++i) {
+                        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                        if (i & 1) {
+                            got += Q.pop(x);
+                        }
+                        else {
+                            Q.push((long)(seed >> 33));
+                        }
+                    }
+                    total += got;
+                });
+            }
+            for (auto& w : workers) { w.join(); }
+            popped = total;
+        });
+        cout << ", popped = " << popped << endl;
+    }
+}
+/* heap_benchmark_updates:
+ *   a scheduler like workload, n tasks with random priorities, then
+ *   m rounds to lower the priority of a random task and pop the root
+ *   every 4 rounds. compare the lazy insertion on HeapTree (push again,
+ *   skip the outdated entries) with the decrease_key() of IndexedHeap.
+ */
+void heap_benchmark_updates(int n, int m)
+{
+    vector<long> priority(n);
+    vector<int>  target(m);
+    vector<long> lowered(m);
+    for (int i = 0; i < n; ++i) { priority[i] = rand(); }
+    for (int j = 0; j < m; ++j) { target[j] = rand() % n; lowered[j] = rand() % 1024; }
+
+    int  lazy_max_size = 0;
+    TESTING_HEAP("Lazy Insertion (HeapTree) ", {
+        vector<long> current(priority);
+        vector<bool> done(n, false);
+        vector<pair<long, int>> entries;
+        MinHeap<pair<long, int>> Q(entries, 4);
+        for (int i = 0; i < n; ++i) { Q.push(make_pair(current[i], i)); }
+        for (int j = 0; j < m; ++j) {
+            int h = target[j];
+            if (!done[h] && lowered[j] < current[h]) {
+                current[h] = lowered[j];
+                Q.push(make_pair(current[h], h));
+            }
+            if ((j & 3) == 3) {
+                while (Q.get_size() > 0) {
+                    auto top = Q.pop();
+                    if (!done[top.second] && top.first == current[top.second]) {
+                        done[top.second] = true;
+                        break;
+                    }
+                }
+            }
+            lazy_max_size = max(lazy_max_size, Q.get_size());
+        }
+    });
+    cout << ", max size = " << lazy_max_size << endl;
+
+    int  indexed_max_size = 0;
+    TESTING_HEAP("Decrease Key (IndexedHeap)", {
+        IndexedHeap<long> Q(n, MIN_HEAP, 4);
+        for (int i = 0; i < n; ++i) { Q.push(i, priority[i]); }
+        for (int j = 0; j < m; ++j) {
+            int h = target[j];
+            if (Q.contains(h) && lowered[j] < Q.get_key(h)) {
+                Q.decrease_key(h, lowered[j]);
+            }
+            if ((j & 3) == 3 && Q.get_size() > 0) {
+                Q.pop();
+            }
+            indexed_max_size = max(indexed_max_size, Q.get_size());
+        }
+    });
+    cout << ", max size = " << indexed_max_size << endl;
+}
+
 /* main:
  *   testing driver main.
- *   could take one argument as the size of the heap.
+ *   could take one argument as the size of the heap,
+ *   and a second one to run the benchmarks with that many elements.
  */
 int main(int argc, char *argv[])
 {   
@@ -282,5 +1838,61 @@ int main(int argc, char *argv[])
     max_heap.sort();
     max_heap.display_heap_array("Max-Heap Sort");
 
+    IndexedHeap<long> indexed_heap(n, MIN_HEAP, 4);
+    for (int i = 0; i < n; ++i) {
+        indexed_heap.push(i, A[i]);
+    }
+    for (int i = 0; i < n; i += 2) {
+        indexed_heap.decrease_key(i, indexed_heap.get_key(i) / 2);
+    }
+    for (int i = 1; i < n; i += 4) {
+        indexed_heap.increase_key(i, indexed_heap.get_key(i) * 2);
+    }
+    for (int i = 3; i < n; i += 4) {
+        indexed_heap.erase(i);
+    }
+    cout << "\e[1m" << "Indexed 4-ary Min-Heap Pop (key(handle): even keys halved, 4i+1 doubled, 4i+3 erased)" << "\e[0m" << ": " << endl;
+    cout << "H[" << indexed_heap.get_size() << "] = ";
+    while (indexed_heap.get_size() > 0) {
+        int h = indexed_heap.pop();
+        cout << indexed_heap.get_key(h) << "(" << h << "), ";
+    }
+    cout << endl;
+
+    MinMaxHeap<long> min_max_heap(v);
+    cout << "\e[1m" << "Min-Max Heap Pop (min, max, min, max ...)" << "\e[0m" << ": " << endl;
+    cout << "H[" << min_max_heap.get_size() << "] = ";
+    for (int i = 0; min_max_heap.get_size() > 0; ++i) {
+        cout << (i & 1 ? min_max_heap.pop_max() : min_max_heap.pop_min()) << ", ";
+    }
+    cout << endl;
+
+    PairingHeap<long> pairing_heap, pairing_other;
+    for (int i = 0; i < n; ++i) {
+        (i & 1 ? pairing_other : pairing_heap).push(A[i]);
+    }
+    pairing_heap.meld(pairing_other);
+    cout << "\e[1m" << "Pairing Min-Heap Meld Pop (even and odd elements melded)" << "\e[0m" << ": " << endl;
+    cout << "H[" << pairing_heap.get_size() << "] = ";
+    while (pairing_heap.get_size() > 0) {
+        cout << pairing_heap.pop() << ", ";
+    }
+    cout << endl;
+
+    if (argc > 2) {
+        int bench_n = atoi(argv[2]);
+        heap_benchmark_arity(bench_n);
+        heap_benchmark_moves(bench_n / 4);
+        heap_benchmark_bulk(bench_n * 4);
+        heap_benchmark_topk(bench_n * 4, 100);
+        heap_benchmark_layout(bench_n, bench_n);
+        heap_benchmark_layout(bench_n * 10, bench_n);
+        heap_benchmark_meld(bench_n, 64);
+        heap_benchmark_kway(bench_n, 256);
+        heap_benchmark_concurrent(bench_n, bench_n, max(4, (int)thread::hardware_concurrency()));
+        heap_benchmark_updates(bench_n, bench_n * 8);
+    }
+
     return 0;
-}
\ No newline at end of file
+}
+#endif  // HEAP_LIBRARY
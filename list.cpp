@@ -16,6 +16,7 @@
 //
 // linked list sorting
 //   - merge sort
+//   - k-way merge of sorted lists (loser tree, see heap.cpp)
 //   - insertion sort
 //   - quick sort (doubly linked list, not implemented)
 //
@@ -30,6 +31,9 @@
 //
 #include <iostream>
 
+#define HEAP_LIBRARY    // LoserTree without the heap testing driver
+#include "heap.cpp"
+
 using namespace std;
 
 struct SinglyNode {
@@ -296,32 +300,73 @@ SinglyNode* singly_linked_list_search_all(SinglyNode *slist, int data)
 }
 /**********************************************************************
  * merge two sorted singly linked list into one sorted singly linked list
- * - the sort is in ascending order.
+ * - the sort is in ascending order, stable (list1 first on the ties).
+ * - iterative two-pointer merge, long lists don't overflow the stack,
+ *   no allocation, so the merge sort calls it O(n) times cheaply.
  *  Input: (SinglyNode *)list1 - the head pointer of a sorted singly linked list
  *       : (SinglyNode *)list2 - the head pointer of a sorted singly linked list
  * Return: the head pointer of the merged singly linked list
  */
 SinglyNode* singly_linked_list_merge(SinglyNode *list1, SinglyNode *list2)
 {
-    if ( !(list1) ) {
-        return list2;
-    }
-    else if ( !(list2) ) {
-        return list1;
+    SinglyNode head;
+    SinglyNode *tail = &head;
+    while (list1 && list2) {
+        if (list2->data < list1->data) {
+            tail = tail->next = list2;
+            list2 = list2->next;
+        }
+        else {
+            tail = tail->next = list1;
+            list1 = list1->next;
+        }
     }
+    tail->next = list1 ? list1 : list2;
 
-    SinglyNode *mlist = NULL;
-
-    if ( list1->data < list2->data ) {
-        mlist = list1;
-        mlist->next = singly_linked_list_merge(list1->next, list2);
+    return head.next;
+}
+/**********************************************************************
+ * merge k sorted singly linked lists into one sorted singly linked list
+ * - the heads of the lists play in a loser tree, the winner (the smallest)
+ *   is linked to the merged list, and the next node of its list replays,
+ *   log2(k) comparisons per node, no recursion and no new node.
+ * - the sort is in ascending order, stable among the lists.
+ * - two lists are merged by singly_linked_list_merge, no loser tree.
+ *  Input: (SinglyNode **)lists - the head pointers of k sorted lists
+ *       : (int)k - the number of the lists
+ * Return: the head pointer of the merged singly linked list
+ */
+struct SinglyNodeLess {
+    bool operator()(const SinglyNode *a, const SinglyNode *b) const { return a->data < b->data; }
+};
+SinglyNode* singly_linked_list_merge_k(SinglyNode *lists[], int k)
+{
+    if (k <= 2) {
+        return k == 2 ? singly_linked_list_merge(lists[0], lists[1]) : (k == 1 ? lists[0] : NULL);
     }
-    else {
-        mlist = list2;
-        mlist->next = singly_linked_list_merge(list1, list2->next);
+    LoserTree<SinglyNode *, SinglyNodeLess> L(k);
+    for (int i = 0; i < k; ++i) {
+        if (lists[i]) {
+            L.set(i, lists[i]);
+        }
+    }
+    L.build();
+
+    SinglyNode head;
+    SinglyNode *tail = &head;
+    while ( !L.empty() ) {
+        SinglyNode *node = L.top_key();
+        tail = tail->next = node;
+        if (node->next) {
+            L.replace_top(node->next);
+        }
+        else {
+            L.pop();
+        }
     }
+    tail->next = NULL;
 
-    return mlist;
+    return head.next;
 }
 /**********************************************************************
  * implements the merge sort algorithm to sort a singly linked list
@@ -505,6 +550,15 @@ int main(int argc, char* argv[])
     cout << "reverse: ";  head = singly_linked_list_reverse(head);          singly_linked_list_print(head);
     cout << "merge sort:     ";  head = singly_linked_list_merge_sort(&head);  singly_linked_list_print(head);
 
+    SinglyNode *lists[3];
+    for (int i = 0; i < 3; ++i) {
+        lists[i] = singly_linked_list_create(a + i * n / 3, (i + 1) * n / 3 - i * n / 3);
+        singly_linked_list_merge_sort(&lists[i]);
+        cout << "sorted list " << i << ":  ";  singly_linked_list_print(lists[i]);
+    }
+    cout << "merge 3 lists:  ";  head = singly_linked_list_merge_k(lists, 3);  singly_linked_list_print(head);
+    singly_linked_list_free(&head);
+
     cout << "create list:    ";  head = singly_linked_list_create(a, n);    singly_linked_list_print(head);
     cout << "insertion sort: ";  head = singly_linked_list_insertion_sort(&head);  singly_linked_list_print(head);
 
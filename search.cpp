@@ -1,14 +1,45 @@
 //   Search Algorithm
 //     Linear Search
 //     Partition Search
-//     Binary Search
+//     SIMD Linear Search (SSE4.2, AVX2, AVX-512), Parallel Search
+//     Binary Search, Branchless Binary Search, Eytzinger Search
 //     Interpolation Search
+//     Batched Searches (binary, interpolation, Eytzinger)
 //     Fibonacci Search
-//     Hash Search, see hash.cpp
+//     Learned Index (piecewise linear, PGM style)
+//     Span Searches (size_t indexes, any integral key type)
+//     Key File Search (memory mapped sorted keys with a sparse index)
+//     Hash Search (swiss table), see hash.cpp
 //     Binary Tree Search, see tree.cpp
 //
 
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <climits>
+#include <type_traits>
+#include <cstring>
+
+// the key files are memory mapped on the POSIX systems
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define SEARCH_MMAP
+#endif
+
+// the SIMD kernels compare the 64-bit long keys on x86
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && __SIZEOF_LONG__ == 8
+#include <immintrin.h>
+#define SEARCH_SIMD
+#endif
+
+#define HASH_LIBRARY    // HashIndex without the hash testing driver
+#include "hash.cpp"
 
 using namespace std;
 
@@ -75,6 +106,171 @@ int partition_search(long a[], int sz, int k, long key)
     }
     return -1;
 }
+/* SIMD Linear Search
+ *   the linear search compares 2 (SSE4.2), 4 (AVX2) or 8 (AVX-512) keys
+ *   in one instruction, and 4, 8, 16 keys in one loop by two registers.
+ *   the equal lanes are turned into a bit mask, the lowest bit set is
+ *   the first index found.
+ *   linear_search_simd() takes the best kernel of the CPU at run time,
+ *   the same as linear_search() on the other CPUs.
+ * time complexity: O(n), n/4 .. n/16 loops
+ * space complexity: O(1)
+ */
+#ifdef SEARCH_SIMD
+__attribute__((target("sse4.2")))
+int linear_search_sse42(long a[], int sz, long key)
+{
+    const __m128i k = _mm_set1_epi64x(key);
+    int i = 0;
+    for (; i + 4 <= sz; i += 4) {
+        __m128i x0 = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i x1 = _mm_loadu_si128((const __m128i*)(a + i + 2));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(x0, k))) |
+                   _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(x1, k))) << 2;
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i < sz; ++i) {
+        if (a[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+__attribute__((target("avx2")))
+int linear_search_avx2(long a[], int sz, long key)
+{
+    const __m256i k = _mm256_set1_epi64x(key);
+    int i = 0;
+    for (; i + 8 <= sz; i += 8) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i x1 = _mm256_loadu_si256((const __m256i*)(a + i + 4));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x0, k))) |
+                   _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x1, k))) << 4;
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i < sz; ++i) {
+        if (a[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+__attribute__((target("avx512f")))
+int linear_search_avx512(long a[], int sz, long key)
+{
+    const __m512i k = _mm512_set1_epi64(key);
+    int i = 0;
+    for (; i + 16 <= sz; i += 16) {
+        __m512i x0 = _mm512_loadu_si512((const void*)(a + i));
+        __m512i x1 = _mm512_loadu_si512((const void*)(a + i + 8));
+        int mask = _mm512_cmpeq_epi64_mask(x0, k) | _mm512_cmpeq_epi64_mask(x1, k) << 8;
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i < sz; ++i) {
+        if (a[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+#endif
+typedef int (*search_kernel)(long a[], int sz, long key);
+search_kernel linear_search_kernel()
+{
+#ifdef SEARCH_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return linear_search_avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return linear_search_avx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return linear_search_sse42;
+    }
+#endif
+    return linear_search;
+}
+int linear_search_simd(long a[], int sz, long key)
+{
+    static const search_kernel kernel = linear_search_kernel();
+    return kernel(a, sz, key);
+}
+/* partition search (SIMD):
+ *   the same k segments as the partition search, the segments take turns
+ *   to search a block of 64 keys by the SIMD linear search, from the
+ *   beginning of each segment forward.
+ */ 
+#define SEARCH_BLOCK    64
+int partition_search_simd(long a[], int sz, int k, long key)
+{
+    if (k <= 0 || sz <= 0) {
+        return -1;
+    }
+    int sz1 = (sz + k - 1) / k;
+    for (int n = 0; n < sz1; n += SEARCH_BLOCK) {
+        int len = min(SEARCH_BLOCK, sz1 - n);
+        for (int i = 0; i < k; ++i) {
+            int first = i * sz1 + n;
+            if (first >= sz) {      // the last segments are empty when sz is small
+                break;
+            }
+            int r = linear_search_simd(a + first, min(len, sz - first), key);
+            if (r >= 0) {
+                return first + r;
+            }
+        }
+    }
+    return -1;
+}
+/* parallel search:
+ *   split the array into one part per thread, every thread searches its
+ *   part by blocks (SEARCH_BLOCK * 64 keys) with the SIMD linear search.
+ *   found keeps the lowest index found so far, a thread stops (early
+ *   cancellation) when its next block starts after the index found,
+ *   because nothing it could find would be the first one.
+ *   return: the first index of the key, the same as the linear search.
+ * applications:
+ *    - a few searches on a huge unsorted array, the threads are started
+ *      for every search.
+ */
+int parallel_search(long a[], int sz, int threads, long key)
+{
+    atomic<int> found(sz);
+    threads = max(1, min(threads, sz / (SEARCH_BLOCK * 64) + 1));
+    const int part = (sz + threads - 1) / threads;
+
+    auto search_part = [&](int t) {
+        int last = min(sz, (t + 1) * part);
+        for (int first = t * part; first < last; first += SEARCH_BLOCK * 64) {
+            if (found.load(memory_order_relaxed) < first) {
+                return;
+            }
+            int r = linear_search_simd(a + first, min(SEARCH_BLOCK * 64, last - first), key);
+            if (r >= 0) {
+                int i = first + r;
+                int f = found.load(memory_order_relaxed);
+                while (i < f && !found.compare_exchange_weak(f, i)) { }
+                return;
+            }
+        }
+    };
+    vector<thread> workers;
+    for (int t = 1; t < threads; ++t) {
+        workers.emplace_back(search_part, t);
+    }
+    search_part(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    return found < sz ? found.load() : -1;
+}
 /* Binary Search
  *    cut the searching range by half after comparing the data at the middle.
  *    change the searching range to the first half or the back half.
@@ -112,6 +308,85 @@ int my_binary_search(long a[], int sz, long key)
     }
     return -1;
 }
+/* Branchless Binary Search (lower bound)
+ *   the binary search branches on the comparison of the key at the middle,
+ *   the branch is mispredicted half of the time on random keys.
+ *   the branchless search keeps the base of the range and its size only,
+ *   the comparison moves the base by a conditional move, no branch.
+ *   the loop always runs log2(n) times, it doesn't stop at the key, and
+ *   the two possible middles of the next step are prefetched, so the
+ *   next memory access is in the cache whichever half is taken.
+ * return: branchless_lower_bound: the first index of a[i] >= key, or sz
+ *         branchless_search: the index of the key, -1 if not found.
+ * time complexity: O(log(n))
+ * space complexity: O(1)
+ */
+int branchless_lower_bound(long a[], int sz, long key)
+{
+    if (sz <= 0) {
+        return 0;
+    }
+    long *base = a;
+    int n = sz;
+    while (n > 1) {
+        int half = n >> 1;
+        __builtin_prefetch(base + (half >> 1));
+        __builtin_prefetch(base + half + (half >> 1));
+        base = (base[half] < key) ? base + half : base;
+        n -= half;
+    }
+    return (base - a) + (*base < key);
+}
+int branchless_search(long a[], int sz, long key)
+{
+    int i = branchless_lower_bound(a, sz, key);
+    return (i < sz && a[i] == key) ? i : -1;
+}
+/* Eytzinger Search
+ *   a sorted array is laid out in the BFS order of a complete binary
+ *   search tree (like a heap), e[1] is the root, e[2k] and e[2k+1] are the
+ *   children of e[k]. the top levels of the tree are in a few cache lines,
+ *   the search goes down k = 2k + (e[k] < key) without any branch, and
+ *   prefetches the cache line of the descendants 3 levels below (e[8k]),
+ *   when e[] is aligned to the 64-byte cache lines.
+ * eytzinger_build:
+ *   lay out the sorted a[0..sz) into e[1..sz], e[] has sz + 1 elements.
+ *   an in-order walk of the tree takes the elements of a[] in order.
+ *   rank[k] (optional, sz + 1 elements) is the index in a[] of e[k].
+ * eytzinger_search:
+ *   return the index of the key in e[], -1 if not found.
+ *   the lower bound is e[k] after the trailing 1 bits of k (the right
+ *   turns after the last left turn) are removed.
+ * time complexity: O(n) to build, O(log(n)) to search
+ * space complexity: O(n) for the index
+ */
+int eytzinger_fill(long a[], long e[], int rank[], int i, int k, int sz)
+{
+    if (k <= sz) {
+        i = eytzinger_fill(a, e, rank, i, 2 * k, sz);
+        if (rank != NULL) {
+            rank[k] = i;
+        }
+        e[k] = a[i++];
+        i = eytzinger_fill(a, e, rank, i, 2 * k + 1, sz);
+    }
+    return i;
+}
+void eytzinger_build(long a[], int sz, long e[], int rank[] = NULL)
+{
+    e[0] = 0;
+    eytzinger_fill(a, e, rank, 0, 1, sz);
+}
+int eytzinger_search(long e[], int sz, long key)
+{
+    unsigned long k = 1;
+    while (k <= (unsigned long)sz) {
+        __builtin_prefetch(e + 8 * k);
+        k = 2 * k + (e[k] < key);
+    }
+    k >>= __builtin_ffsl(~k);
+    return (k > 0 && e[k] == key) ? (int)k : -1;
+}
 /* Golden Search
  *    like the binary search, but spliting the array based on the golden 
  *    ratio 0.618 (1:1.618), use 0.625 in this implementation.
@@ -148,6 +423,22 @@ int golden_search(long a[], int sz, long key)
     }
     return -1;
 }
+/* interpolation_position:
+ *   the interpolated position of the key in a[first..last], when
+ *   a[first] <= key <= a[last]. the differences of the keys are taken in
+ *   unsigned long, they don't overflow when the keys span more than
+ *   LONG_MAX, the position is clamped to [first, last] against rounding.
+ */
+static inline int interpolation_position(const long a[], int first, int last, long key)
+{
+    if (last == first || a[last] == a[first]) {  // denominator will be 0
+        return last;
+    }
+    double ratio = (double)((unsigned long)key - (unsigned long)a[first]) /
+                   (double)((unsigned long)a[last] - (unsigned long)a[first]);
+    int position = first + (int)(ratio * (last - first));
+    return min(max(position, first), last);
+}
 /* Interpolation Search
  *   instead of using the middle index as in binary search, 
  *   find the index based on the value of Key as below:
@@ -170,17 +461,11 @@ int interpolation_search(long a[], int sz, long key)
     int last  = sz - 1;
     int interpolation;
 
-    // while (first <= last && key >= a[first] && key <= a[last]) {  // quickly find out if the key is in the list
-    while (first <= last) 
+    // stop when the key is out of the range, the interpolation would be
+    // out of the range too, and the range would grow back (a key not in).
+    while (first <= last && key >= a[first] && key <= a[last]) 
     {
-        if (last == first || a[last] == a[first]) {  // denominator will be 0
-            interpolation = last;
-        }
-        else {
-            // int interpolation = first + (last - first) * (key - a[first]) / (a[last] - a[first]);
-            // unsigned long long interpolation = (unsigned long long)(last - first) * (key - a[first]) / (a[last] - a[first]);
-            interpolation = first + (((double)(last - first) / (a[last] - a[first])) * (key - a[first]));
-        }
+        interpolation = interpolation_position(a, first, last, key);
 
         if (key == a[interpolation]) {
             return interpolation;
@@ -194,6 +479,221 @@ int interpolation_search(long a[], int sz, long key)
     }
     return -1;
 }
+/* Batched Searches
+ *   search m keys in one call, result[j] is the index of keys[j] (-1 if
+ *   not found), the same as the search of one key.
+ *   a search of one key waits for the memory (DRAM) at every step, the
+ *   batched searches take a group of keys (SEARCH_GROUP) in lock-step:
+ *   one step of every key in the group, the memory accesses of the keys
+ *   are prefetched and overlapped, the latency is paid once per step of
+ *   the group instead of once per step of every key.
+ * binary_search_batch:
+ *   the branchless binary search, all the keys take the same steps.
+ * eytzinger_search_batch:
+ *   the Eytzinger search, the keys take the same steps (or one more).
+ *   the e[] index found is mapped back by rank[] (see eytzinger_build),
+ *   so result[j] is the index in the sorted a[], the same as the others.
+ * interpolation_search_batch:
+ *   the keys take different steps, every slot of the group is a search
+ *   in progress (like a coroutine), it computes the next position and
+ *   prefetches it, then gives the turn to the next slot, and reads the
+ *   position at its next turn. a slot takes the next key when it is done.
+ */
+#define SEARCH_GROUP    16
+void binary_search_batch(long a[], int sz, const long keys[], int m, int result[])
+{
+    for (int j0 = 0; j0 < m; j0 += SEARCH_GROUP) {
+        const int g = min(SEARCH_GROUP, m - j0);
+        long *base[SEARCH_GROUP];
+        for (int i = 0; i < g; ++i) {
+            base[i] = a;
+        }
+        for (int n = sz; n > 1; n -= n >> 1) {
+            int half = n >> 1;
+            for (int i = 0; i < g; ++i) {
+                __builtin_prefetch(base[i] + (half >> 1));
+                __builtin_prefetch(base[i] + half + (half >> 1));
+            }
+            for (int i = 0; i < g; ++i) {
+                base[i] = (base[i][half] < keys[j0 + i]) ? base[i] + half : base[i];
+            }
+        }
+        for (int i = 0; i < g; ++i) {
+            int k = sz > 0 ? (base[i] - a) + (*base[i] < keys[j0 + i]) : 0;
+            result[j0 + i] = (k < sz && a[k] == keys[j0 + i]) ? k : -1;
+        }
+    }
+}
+void eytzinger_search_batch(long e[], const int rank[], int sz, const long keys[], int m, int result[])
+{
+    for (int j0 = 0; j0 < m; j0 += SEARCH_GROUP) {
+        const int g = min(SEARCH_GROUP, m - j0);
+        unsigned long k[SEARCH_GROUP];
+        for (int i = 0; i < g; ++i) {
+            k[i] = 1;
+        }
+        for (bool active = true; active; ) {
+            active = false;
+            for (int i = 0; i < g; ++i) {
+                if (k[i] <= (unsigned long)sz) {
+                    __builtin_prefetch(e + 8 * k[i]);
+                    k[i] = 2 * k[i] + (e[k[i]] < keys[j0 + i]);
+                    active = true;
+                }
+            }
+        }
+        for (int i = 0; i < g; ++i) {
+            unsigned long x = k[i] >> __builtin_ffsl(~k[i]);
+            result[j0 + i] = (x > 0 && e[x] == keys[j0 + i]) ? rank[x] : -1;
+        }
+    }
+}
+void interpolation_search_batch(long a[], int sz, const long keys[], int m, int result[])
+{
+    struct Slot {
+        int  j;             // the key of the slot, -1 if idle
+        int  first, last;   // the range of the search
+        int  position;      // prefetched, read at the next turn
+    } slot[SEARCH_GROUP];
+
+    // start the search of the key j in the slot s, or finish it at once
+    int next = 0;
+    auto start = [&](Slot& s) {
+        s.j = -1;
+        while (next < m) {
+            int j = next++;
+            long key = keys[j];
+            if (sz <= 0 || key < a[0] || key > a[sz - 1]) {
+                result[j] = -1;
+                continue;
+            }
+            s.j = j;
+            s.first = 0;
+            s.last = sz - 1;
+            s.position = interpolation_position(a, s.first, s.last, key);
+            __builtin_prefetch(a + s.position);
+            return;
+        }
+    };
+
+    for (int i = 0; i < SEARCH_GROUP; ++i) {
+        start(slot[i]);
+    }
+    for (int busy = SEARCH_GROUP; busy > 0; ) {
+        busy = 0;
+        for (int i = 0; i < SEARCH_GROUP; ++i) {
+            Slot& s = slot[i];
+            if (s.j < 0) {
+                continue;
+            }
+            long key = keys[s.j];
+            long x = a[s.position];
+            if (x == key) {
+                result[s.j] = s.position;
+                start(s);
+            }
+            else {
+                if (x < key) { s.first = s.position + 1; }
+                else         { s.last = s.position - 1; }
+                if (s.first > s.last || key < a[s.first] || key > a[s.last]) {
+                    result[s.j] = -1;
+                    start(s);
+                }
+                else {
+                    s.position = interpolation_position(a, s.first, s.last, key);
+                    __builtin_prefetch(a + s.position);
+                }
+            }
+            busy += s.j >= 0;
+        }
+    }
+}
+/* Learned Index (piecewise linear index)
+ *   the interpolation search takes the keys as one straight line from the
+ *   first to the last, it is far off on the skewed keys. the learned index
+ *   takes the keys as a few line segments: each segment predicts the index
+ *   of a key within eps (error bound), a binary search of the first keys of
+ *   the segments finds the segment, and the last-mile binary search only
+ *   looks at the 2 * eps + 1 elements around the prediction.
+ * learned_index_build (shrinking cone, one pass):
+ *   a segment starts at a key (x0, index y0), the range of its slope is
+ *   narrowed by every next key (x, y) to [(y - eps - y0)/(x - x0), 
+ *   (y + eps - y0)/(x - x0)], a new segment starts when it is empty.
+ *   only the first index of the duplicated keys counts (the lower bound).
+ * learned_index_search:
+ *   return the index of the key in a[], -1 if not found.
+ * time complexity: O(n) to build, O(log(segments) + log(eps)) to search
+ * space complexity: O(segments), see learned_index_size()
+ */
+struct LearnedIndex {
+    int eps;                    // the max error of a prediction
+    vector<long>   keys;        // the first key of every segment
+    vector<double> slopes;      // index = start + slope * (key - first key)
+    vector<int>    starts;      // the index of the first key
+};
+void learned_index_build(long a[], int sz, int eps, LearnedIndex& index)
+{
+    index.eps = eps;
+    index.keys.clear();
+    index.slopes.clear();
+    index.starts.clear();
+
+    double lo = 0, hi = 0;
+    for (int i = 0; i < sz; ++i) {
+        if (i > 0 && a[i] == a[i - 1]) {
+            continue;
+        }
+        if (!index.keys.empty()) {
+            // a[i] > the first key of the segment, no overflow in unsigned
+            double dx = (double)((unsigned long)a[i] - (unsigned long)index.keys.back());
+            double y = i - index.starts.back();
+            double l = max(lo, (y - eps) / dx);
+            double h = min(hi, (y + eps) / dx);
+            if (l <= h) {
+                lo = l;
+                hi = h;
+                index.slopes.back() = (lo + hi) / 2;
+                continue;
+            }
+        }
+        index.keys.push_back(a[i]);
+        index.slopes.push_back(0);
+        index.starts.push_back(i);
+        lo = 0;
+        hi = HUGE_VAL;
+    }
+}
+int learned_index_search(LearnedIndex& index, long a[], int sz, long key)
+{
+    int segments = index.keys.size();
+    if (segments == 0 || key < index.keys[0]) {
+        return -1;
+    }
+    // the last segment with the first key <= key
+    int s = branchless_lower_bound(index.keys.data(), segments, key);
+    if (s == segments || index.keys[s] > key) {
+        --s;
+    }
+    double p = index.starts[s] + index.slopes[s] * (double)((unsigned long)key - (unsigned long)index.keys[s]);
+    int end = s + 1 < segments ? index.starts[s + 1] : sz;
+    int predict = (int)min(max(p, (double)index.starts[s]), (double)(end - 1));
+
+    // the last mile, widen the window in case of the rounding errors
+    int first = max(index.starts[s], predict - index.eps - 1);
+    int last = min(end, predict + index.eps + 2);
+    if (a[first] > key) {
+        first = index.starts[s];
+    }
+    if (last < end && a[last - 1] < key) {
+        last = end;
+    }
+    int i = first + branchless_lower_bound(a + first, last - first, key);
+    return (i < sz && a[i] == key) ? i : -1;
+}
+long learned_index_size(LearnedIndex& index)
+{
+    return index.keys.size() * (sizeof(long) + sizeof(double) + sizeof(int));
+}
 /* Fibonacci Search
  *   split the array into two parts by dividing its size into two
  *   Fibonacci numbers: fab1 + fab2 = size
@@ -236,12 +736,282 @@ int fibonacci_search(long a[], int sz, long key)
     return -1; 
 }
 
+/* Span Searches
+ *   the searches above take an int size and return an int index, they
+ *   stop at 2^31 elements. the span searches take a span (pointer and
+ *   size_t size) of any integral key type, and return a size_t index,
+ *   SEARCH_NOT_FOUND if the key is not in.
+ *   span_linear_search:         the linear search.
+ *   span_lower_bound:           the branchless lower bound.
+ *   span_binary_search:         the binary search by the lower bound.
+ *   span_interpolation_search:  the interpolation search, overflow safe,
+ *      the position is (last - first) * (key - a[first]) / (a[last] - a[first])
+ *      in the unsigned integers, the differences of two keys always fit,
+ *      the product takes 128 bits, no double rounding on 2^53 or more.
+ */
+#define SEARCH_NOT_FOUND    ((size_t)-1)
+template<class Key>
+struct KeySpan {
+    static_assert(is_integral<Key>::value, "the keys must be integral");
+    const Key *data;
+    size_t size;
+    KeySpan(const Key *a, size_t n) : data(a), size(n) { }
+    KeySpan(const vector<Key>& v) : data(v.data()), size(v.size()) { }
+    const Key& operator[](size_t i) const { return data[i]; }
+};
+template<class Key>
+size_t span_linear_search(KeySpan<Key> a, Key key)
+{
+    for (size_t i = 0; i < a.size; ++i) {
+        if (a[i] == key) {
+            return i;
+        }
+    }
+    return SEARCH_NOT_FOUND;
+}
+template<class Key>
+size_t span_lower_bound(KeySpan<Key> a, Key key)
+{
+    if (a.size == 0) {
+        return 0;
+    }
+    const Key *base = a.data;
+    for (size_t n = a.size; n > 1; n -= n >> 1) {
+        size_t half = n >> 1;
+        __builtin_prefetch(base + (half >> 1));
+        __builtin_prefetch(base + half + (half >> 1));
+        base = (base[half] < key) ? base + half : base;
+    }
+    return (base - a.data) + (*base < key);
+}
+template<class Key>
+size_t span_binary_search(KeySpan<Key> a, Key key)
+{
+    size_t i = span_lower_bound(a, key);
+    return (i < a.size && a[i] == key) ? i : SEARCH_NOT_FOUND;
+}
+template<class Key>
+size_t span_interpolation_search(KeySpan<Key> a, Key key)
+{
+    typedef typename make_unsigned<Key>::type UKey;
+    if (a.size == 0 || key < a[0] || key > a[a.size - 1]) {
+        return SEARCH_NOT_FOUND;
+    }
+    size_t first = 0;
+    size_t last = a.size - 1;
+    while (first <= last && key >= a[first] && key <= a[last]) {
+        size_t position = last;
+        if (a[last] != a[first]) {
+            UKey range = (UKey)a[last] - (UKey)a[first];
+            UKey offset = (UKey)key - (UKey)a[first];
+#ifdef __SIZEOF_INT128__
+            position = first + (size_t)((unsigned __int128)(last - first) * offset / range);
+#else
+            position = first + (size_t)((long double)(last - first) * offset / range);
+#endif
+        }
+        if (key == a[position]) {
+            return position;
+        }
+        else if (key > a[position]) {
+            first = position + 1;
+        }
+        else {
+            if (position == 0) {
+                break;
+            }
+            last = position - 1;
+        }
+    }
+    return SEARCH_NOT_FOUND;
+}
+/* Key File Search
+ *   search a file of sorted keys without reading it into the memory.
+ *   the file is mapped (mmap) into the memory, the pages of the file are
+ *   read by the page cache of the OS on the first access only.
+ * file format (native byte order):
+ *   header:   KeyFileHeader, 64 bytes
+ *   keys:     count keys (int64_t), sorted, at a 4 KB boundary
+ *   samples:  every step-th key, keys[0], keys[step], keys[2 * step] ...
+ *             at a 4 KB boundary
+ *   top:      every step-th sample, samples[0], samples[step] ...
+ *   the samples and the top are a two level sparse index, written with
+ *   the keys. opening a file reads the header and copies the top into
+ *   the memory, the top is count / step^2 keys (150 KB for 5 * 10^9 keys
+ *   with the default step), nothing else is read.
+ * key_file_search:
+ *   find the last top key <= key in the memory, then the last sample
+ *   <= key among the step samples after it, then search the step keys
+ *   after that sample. with the default step (512 keys = 4 KB) and the
+ *   keys and samples at 4 KB boundaries, the samples and the keys taken
+ *   are one 4 KB page each, a cold search touches two pages of the file.
+ */
+#define KEY_FILE_MAGIC  "SORTKEY2"
+#define KEY_FILE_STEP   512
+#define KEY_FILE_ALIGN  4096
+struct KeyFileHeader {
+    char     magic[8];
+    uint64_t count;         // number of keys
+    uint64_t step;          // the keys between two samples, the samples between two tops
+    uint64_t samples;       // number of samples, ceil(count / step)
+    uint64_t top;           // number of top keys, ceil(samples / step)
+    uint64_t keys_offset;   // the offsets in the file, multiples of 8
+    uint64_t samples_offset;
+    uint64_t top_offset;
+};
+struct KeyFile {
+    int      fd;
+    size_t   length;        // the file length mapped
+    void    *map;
+    KeyFileHeader header;
+    KeySpan<int64_t> keys;
+    KeySpan<int64_t> samples;
+    vector<int64_t>  top;   // in the memory
+    KeyFile() : fd(-1), length(0), map(NULL), header(), keys(NULL, 0), samples(NULL, 0) { }
+};
+#ifdef SEARCH_MMAP
+/* key_file_level: the number of the samples of n keys, ceil(n / step).
+ * key_file_region: whether n keys at offset are in the file, aligned.
+ */
+uint64_t key_file_level(uint64_t n, uint64_t step)
+{
+    return n == 0 ? 0 : (n - 1) / step + 1;
+}
+bool key_file_region(uint64_t offset, uint64_t n, size_t length)
+{
+    return offset % sizeof(int64_t) == 0 && offset <= length &&
+           n <= (length - offset) / sizeof(int64_t);
+}
+/* key_file_write:
+ *   write the sorted keys and their two levels of samples into a key file.
+ *   return: false if the file cannot be written.
+ */
+bool key_file_write(const char *path, const int64_t *keys, size_t n, size_t step = KEY_FILE_STEP)
+{
+    KeyFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, KEY_FILE_MAGIC, sizeof(header.magic));
+    header.count = n;
+    header.step = max(step, (size_t)1);
+    header.samples = key_file_level(n, header.step);
+    header.top = key_file_level(header.samples, header.step);
+    header.keys_offset = KEY_FILE_ALIGN;
+    header.samples_offset = (header.keys_offset + n * sizeof(int64_t) + KEY_FILE_ALIGN - 1)
+                            / KEY_FILE_ALIGN * KEY_FILE_ALIGN;
+    header.top_offset = header.samples_offset + header.samples * sizeof(int64_t);
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+    static const char zeros[KEY_FILE_ALIGN] = { 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(zeros, 1, header.keys_offset - sizeof(header), file) == header.keys_offset - sizeof(header) &&
+              (n == 0 || fwrite(keys, sizeof(int64_t), n, file) == n);
+    size_t padding = header.samples_offset - header.keys_offset - n * sizeof(int64_t);
+    ok = ok && fwrite(zeros, 1, padding, file) == padding;
+    for (size_t i = 0; ok && i < n; i += header.step) {
+        ok = fwrite(keys + i, sizeof(int64_t), 1, file) == 1;
+    }
+    for (size_t i = 0; ok && i < n; i += header.step * header.step) {
+        ok = fwrite(keys + i, sizeof(int64_t), 1, file) == 1;
+    }
+    return fclose(file) == 0 && ok;
+}
+/* key_file_close, key_file_open:
+ *   map a key file into the memory, check its header, copy the top.
+ *   return: false if the file cannot be opened or it is not a key file,
+ *           or its header doesn't fit the file (truncated, corrupted).
+ */
+void key_file_close(KeyFile& f)
+{
+    if (f.map != NULL) {
+        munmap(f.map, f.length);
+    }
+    if (f.fd >= 0) {
+        close(f.fd);
+    }
+    f = KeyFile();
+}
+bool key_file_open(const char *path, KeyFile& f)
+{
+    struct stat st;
+    f.fd = open(path, O_RDONLY);
+    if (f.fd < 0) {
+        return false;
+    }
+    if (fstat(f.fd, &st) != 0 || (size_t)st.st_size < sizeof(KeyFileHeader)) {
+        close(f.fd);
+        f.fd = -1;
+        return false;
+    }
+    f.length = st.st_size;
+    f.map = mmap(NULL, f.length, PROT_READ, MAP_SHARED, f.fd, 0);
+    if (f.map == MAP_FAILED) {
+        f.map = NULL;
+        close(f.fd);
+        f.fd = -1;
+        return false;
+    }
+    const char *base = (const char *)f.map;
+    const KeyFileHeader& h = f.header;
+    memcpy(&f.header, base, sizeof(f.header));
+    if (memcmp(h.magic, KEY_FILE_MAGIC, sizeof(h.magic)) != 0 || h.step == 0 ||
+        h.samples != key_file_level(h.count, h.step) ||
+        h.top != key_file_level(h.samples, h.step) ||
+        h.keys_offset < sizeof(h) ||
+        !key_file_region(h.keys_offset, h.count, f.length) ||
+        !key_file_region(h.samples_offset, h.samples, f.length) ||
+        !key_file_region(h.top_offset, h.top, f.length)) {
+        key_file_close(f);
+        return false;
+    }
+    f.keys = KeySpan<int64_t>((const int64_t *)(base + h.keys_offset), h.count);
+    f.samples = KeySpan<int64_t>((const int64_t *)(base + h.samples_offset), h.samples);
+    const int64_t *top = (const int64_t *)(base + h.top_offset);
+    f.top.assign(top, top + h.top);
+    madvise(f.map, f.length, MADV_RANDOM);     // no read ahead of the keys
+    return true;
+}
+/* key_file_search:
+ *   return the index of the key in the file, SEARCH_NOT_FOUND if not in.
+ *   interpolation: use the interpolation search in the step keys,
+ *   otherwise the binary search.
+ */
+size_t key_file_search(KeyFile& f, int64_t key, bool interpolation = false)
+{
+    const size_t step = f.header.step;
+    KeySpan<int64_t> top(f.top.data(), f.top.size());
+    if (top.size == 0 || key < top[0]) {
+        return SEARCH_NOT_FOUND;
+    }
+    // the last top key <= key, in the memory
+    size_t t = span_lower_bound(top, key);
+    if (t == top.size || top[t] > key) {
+        --t;
+    }
+    // the last sample <= key, in the step samples from the top key
+    size_t s0 = t * step;
+    KeySpan<int64_t> samples(f.samples.data + s0, min(step, f.samples.size - s0));
+    size_t s = span_lower_bound(samples, key);
+    if (s == samples.size || samples[s] > key) {
+        --s;
+    }
+    // the key, in the step keys from the sample
+    size_t first = (s0 + s) * step;
+    KeySpan<int64_t> block(f.keys.data + first, min(step, f.keys.size - first));
+    size_t i = interpolation ? span_interpolation_search(block, key) : span_binary_search(block, key);
+    return i == SEARCH_NOT_FOUND ? i : first + i;
+}
+#endif
 /* testing driver code
  */
 #include <chrono>
 #include <functional>
 #include <algorithm>
 #include <vector>
+#include <random>
+#include <limits>
 
 using namespace std::chrono;
 
@@ -257,13 +1027,208 @@ int search_function(long a[], int n, int i, function<int (long*, int, int, long)
     cout << "Elapsed time: " << duration << " us, " << "Average time: " << double(duration) / n << " us" << endl; \
     if (result < 0) { cout << "i = " << i << ", A[i] = " << A[i] << " is not found" << endl; } \
 }
+/* benchmarks on the arrays in the heap memory, too large for the stack,
+ *   q queries (keys[j]) of a search on an array, ns per query.
+ */
+#define TESTING_QUERIES(s, q, ...) { \
+    cout << "\e[1m" << s << "\e[0m" << ": "; \
+    long found = 0; \
+    auto start = chrono::high_resolution_clock::now(); \
+    for (int j = 0; j < q; ++j) { found += (__VA_ARGS__) >= 0; } \
+    auto end = chrono::high_resolution_clock::now(); \
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count(); \
+    cout.setf(ios::fixed); cout.precision(1); \
+    cout << "Average time: " << double(duration) / q << " ns/query, found = " << found << endl; \
+    cout.unsetf(ios::fixed); cout.precision(6); \
+}
+/* search_benchmark_linear:
+ *   the linear searches on an unsorted array of n keys, q random keys of
+ *   the array, the parallel search with all the cores.
+ */
+void search_benchmark_linear(int n, int q)
+{
+    vector<long> A(n), keys(q);
+    for (int i = 0; i < n; ++i) { A[i] = rand(); }
+    for (int j = 0; j < q; ++j) { keys[j] = A[rand() % n]; }
+    long *a = A.data();
+    int threads = max(2u, thread::hardware_concurrency());
+
+    cout << "---- linear searches, n = " << n << ", queries = " << q << " ----" << endl;
+    TESTING_QUERIES("Linear Search          ", q, linear_search(a, n, keys[j]));
+    TESTING_QUERIES("Partition Search       ", q, partition_search(a, n, 22, keys[j]));
+    TESTING_QUERIES("Linear Search (SIMD)   ", q, linear_search_simd(a, n, keys[j]));
+    TESTING_QUERIES("Partition Search (SIMD)", q, partition_search_simd(a, n, 22, keys[j]));
+    TESTING_QUERIES("Parallel Search (" + to_string(threads) + ")    ", q, parallel_search(a, n, threads, keys[j]));
+}
+/* search_benchmark_sorted:
+ *   the searches on a sorted array of n keys, q random keys of the array,
+ *   the Eytzinger index is built once (aligned to the cache lines).
+ */
+void search_benchmark_sorted(int n, int q)
+{
+    vector<long> A(n), keys(q);
+    for (int i = 0; i < n; ++i) { A[i] = rand(); }
+    sort(A.begin(), A.end());
+    for (int j = 0; j < q; ++j) { keys[j] = A[rand() % n]; }
+    long *a = A.data();
+    long *e = static_cast<long*>(::operator new((n + 1) * sizeof(long), align_val_t(64)));
+    eytzinger_build(a, n, e);
+
+    cout << "---- sorted searches, n = " << n << ", queries = " << q << " ----" << endl;
+    TESTING_QUERIES("Binary Search           ", q, my_binary_search(a, n, keys[j]));
+    TESTING_QUERIES("Golden Search           ", q, golden_search(a, n, keys[j]));
+    TESTING_QUERIES("Branchless Binary Search", q, branchless_search(a, n, keys[j]));
+    TESTING_QUERIES("C++ lower_bound         ", q, lower_bound(a, a + n, keys[j]) - a);
+    TESTING_QUERIES("Eytzinger Search        ", q, eytzinger_search(e, n, keys[j]));
+
+    ::operator delete(e, align_val_t(64));
+}
+/* search_benchmark_batch:
+ *   the one key searches against the batched searches of the same keys,
+ *   on a sorted array of n keys, q keys with a half of them not in.
+ */
+#define TESTING_BATCH(s, q, ...) { \
+    cout << "\e[1m" << s << "\e[0m" << ": "; \
+    auto start = chrono::high_resolution_clock::now(); \
+    __VA_ARGS__; \
+    auto end = chrono::high_resolution_clock::now(); \
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count(); \
+    long found = count_if(results.begin(), results.end(), [](int r) { return r >= 0; }); \
+    cout.setf(ios::fixed); cout.precision(1); \
+    cout << "Average time: " << double(duration) / q << " ns/query, found = " << found << endl; \
+    cout.unsetf(ios::fixed); cout.precision(6); \
+}
+void search_benchmark_batch(int n, int q)
+{
+    vector<long> A(n), keys(q);
+    vector<int>  results(q);
+    for (int i = 0; i < n; ++i) { A[i] = 2 * (long)rand(); }
+    sort(A.begin(), A.end());
+    for (int j = 0; j < q; ++j) { keys[j] = A[rand() % n] + (j & 1); }
+    long *a = A.data();
+    long *e = static_cast<long*>(::operator new((n + 1) * sizeof(long), align_val_t(64)));
+    vector<int> rank(n + 1);
+    eytzinger_build(a, n, e, rank.data());
+
+    cout << "---- batched searches, n = " << n << ", queries = " << q << " ----" << endl;
+    TESTING_QUERIES("Binary Search (one by one)       ", q, branchless_search(a, n, keys[j]));
+    TESTING_BATCH  ("Binary Search (batch)            ", q, binary_search_batch(a, n, keys.data(), q, results.data()));
+    TESTING_QUERIES("Interpolation Search (one by one)", q, interpolation_search(a, n, keys[j]));
+    TESTING_BATCH  ("Interpolation Search (batch)     ", q, interpolation_search_batch(a, n, keys.data(), q, results.data()));
+    TESTING_QUERIES("Eytzinger Search (one by one)    ", q, eytzinger_search(e, n, keys[j]));
+    TESTING_BATCH  ("Eytzinger Search (batch)         ", q, eytzinger_search_batch(e, rank.data(), n, keys.data(), q, results.data()));
+
+    ::operator delete(e, align_val_t(64));
+}
+/* search_benchmark_learned:
+ *   the learned index against the binary, interpolation and Fibonacci
+ *   searches on n sorted keys of three distributions:
+ *   uniform, lognormal (skewed), and Zipf-like (heavy tail, duplicates).
+ */
+void search_benchmark_learned(int n, int q)
+{
+    mt19937_64 rng(1);
+    uniform_int_distribution<long> uniform(0, 1L << 48);
+    lognormal_distribution<double> lognormal(0, 2);
+    uniform_real_distribution<double> unit(0, 1);
+    const char *names[] = { "uniform", "lognormal", "zipf" };
+
+    for (int d = 0; d < 3; ++d) {
+        vector<long> A(n), keys(q);
+        for (int i = 0; i < n; ++i) {
+            switch (d) {
+            case 0: A[i] = uniform(rng); break;
+            case 1: A[i] = (long)(lognormal(rng) * 1e9); break;
+            case 2: A[i] = (long)min(1e18, pow(1 - unit(rng), -1 / 0.5)); break;   // Pareto, alpha 0.5
+            }
+        }
+        sort(A.begin(), A.end());
+        for (int j = 0; j < q; ++j) { keys[j] = A[rng() % n]; }
+        long *a = A.data();
+
+        LearnedIndex index;
+        auto start = chrono::high_resolution_clock::now();
+        learned_index_build(a, n, 32, index);
+        auto end = chrono::high_resolution_clock::now();
+        cout << "---- learned index, " << names[d] << ", n = " << n << ", queries = " << q << " ----" << endl;
+        cout << "build time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << " us, "
+             << "segments: " << index.keys.size() << ", model size: " << learned_index_size(index) << " bytes" << endl;
+
+        TESTING_QUERIES("Binary Search       ", q, my_binary_search(a, n, keys[j]));
+        // the interpolation search goes toward O(n) on the skewed keys, 1% of the queries
+        TESTING_QUERIES("Interpolation Search", max(1, q / 100), interpolation_search(a, n, keys[j]));
+        TESTING_QUERIES("Fibonacci Search    ", q, fibonacci_search(a, n, keys[j]));
+        TESTING_QUERIES("Learned Index       ", q, learned_index_search(index, a, n, keys[j]));
+    }
+}
+/* search_benchmark_span:
+ *   the span searches on n sorted keys in the heap memory, n can be
+ *   more than 2^31 (8 bytes per key), e.g. 5 * 10^9 keys take 40 GB.
+ *   the keys are generated in order, no sort needed.
+ */
+template<class Key>
+void search_benchmark_span(size_t n, int q, const char *name)
+{
+    vector<Key> A(n);
+    vector<Key> keys(q);
+    mt19937_64 rng(1);
+    Key x = numeric_limits<Key>::min();
+    for (size_t i = 0; i < n; ++i) { A[i] = x; x += rng() % 4 + (i + 1 < n); }
+    for (int j = 0; j < q; ++j) { keys[j] = A[rng() % n]; }
+    KeySpan<Key> a(A);
+
+    cout << "---- span searches, " << name << ", n = " << n << ", queries = " << q << " ----" << endl;
+    TESTING_QUERIES("Span Binary Search       ", q, (long)span_binary_search(a, keys[j]));
+    TESTING_QUERIES("Span Interpolation Search", q, (long)span_interpolation_search(a, keys[j]));
+    TESTING_QUERIES("Span Linear Search       ", max(1, q / 10000), (long)span_linear_search(a, keys[j]));
+}
+/* search_benchmark_file:
+ *   write n sorted keys into a key file, map it, and search q keys,
+ *   the time to open the file doesn't depend on its size.
+ */
+#ifdef SEARCH_MMAP
+void search_benchmark_file(const char *path, size_t n, int q)
+{
+    vector<int64_t> A(n), keys(q);
+    mt19937_64 rng(1);
+    int64_t x = 0;
+    for (size_t i = 0; i < n; ++i) { A[i] = x; x += rng() % 4 + 1; }
+    for (int j = 0; j < q; ++j) { keys[j] = A[rng() % n] + (j & 1); }
+    if (!key_file_write(path, A.data(), n)) {
+        cout << "cannot write " << path << endl;
+        return;
+    }
+    vector<int64_t>().swap(A);     // the keys are only in the file now
+
+    KeyFile f;
+    auto start = chrono::high_resolution_clock::now();
+    bool opened = key_file_open(path, f);
+    auto end = chrono::high_resolution_clock::now();
+    cout << "---- key file search, n = " << n << ", queries = " << q << " ----" << endl;
+    if (!opened) {
+        cout << "cannot open " << path << endl;
+        return;
+    }
+    cout << "open time: " << chrono::duration_cast<chrono::microseconds>(end - start).count() << " us, "
+         << "file size: " << f.length << " bytes, samples: " << f.samples.size
+         << ", top (in memory): " << f.top.size() << endl;
+    TESTING_QUERIES("Key File Binary Search       ", q, (long)key_file_search(f, keys[j]));
+    TESTING_QUERIES("Key File Interpolation Search", q, (long)key_file_search(f, keys[j], true));
+    key_file_close(f);
+    remove(path);
+}
+#endif
 /* testing main
+ *   could take the size of the arrays to run the benchmarks,
+ *   the sorted searches run on 10^4, 10^5 ... up to that size,
+ *   and a second size (can be more than 2^31) for the span searches.
  */
-int main()
+int main(int argc, char *argv[])
 {
     int i, n = 100000;
     int result;
-    long A[n];
+    vector<long> storage(n);    // the arrays in the heap memory, not on the stack
+    long *A = storage.data();
 
     cout << "---- generate " << n << " random numbers ----" << endl;
     for(i = 0; i < n; ++i) { A[i] = rand() % (n * 10); }
@@ -278,6 +1243,13 @@ int main()
     TESTING_SEARCH("Linear Search", linear_search);
 
     TESTING_SEARCH("Partition Search", partition_search);
+
+    TESTING_SEARCH("Linear Search (SIMD)", linear_search_simd);
+
+    TESTING_SEARCH("Partition Search (SIMD)", partition_search_simd);
+
+    HashIndex index(A, n);      // built once, not in the search time
+    TESTING_SEARCH("Hash Search", [&index](long *, int, long key) { return index.search(key); });
     
     sort(A, A + n);
     cout << "Sorted Array: " << endl;
@@ -288,6 +1260,8 @@ int main()
 
     TESTING_SEARCH("Golden Search", golden_search);
 
+    TESTING_SEARCH("Branchless Binary Search", branchless_search);
+
     TESTING_SEARCH("Interpolation Search", interpolation_search);
 
     TESTING_SEARCH("Fibonacci Search", fibonacci_search);
@@ -297,10 +1271,39 @@ int main()
     sort(V.begin(), V.end());
 	auto start = steady_clock::now();
     for (i = 0; i < n; ++i) {
-        result = binary_search(V.begin(), V.end(), A[i]);
+        if ((result = binary_search(V.begin(), V.end(), A[i])) <= 0) break;   // A[i] is the key not found
     }
 	auto end = steady_clock::now();
     auto duration = chrono::duration_cast<chrono::microseconds>(end - start).count();
     cout << "Elapsed time: " << duration << " us, " << "Average time: " << double(duration) / n << " us" << endl;
     if (result <= 0) { cout << A[i] << " is not found" << endl; }
+
+    // the keys span more than LONG_MAX, their differences overflow in long
+    long W[] = { LONG_MIN + 1, -5, 0, 7, LONG_MAX - 1 };
+    long wkeys[] = { LONG_MIN + 1, -5, 0, 7, LONG_MAX - 1, -6, 1, LONG_MAX - 2 };
+    int wn = sizeof(W) / sizeof(W[0]), wm = sizeof(wkeys) / sizeof(wkeys[0]);
+    int wresults[sizeof(wkeys) / sizeof(wkeys[0])];
+    interpolation_search_batch(W, wn, wkeys, wm, wresults);
+    cout << "Interpolation Search on a wide key range: ";
+    for (i = 0; i < wm; ++i) {
+        cout << interpolation_search(W, wn, wkeys[i]) << "/" << wresults[i] << (i < wm - 1 ? ", " : "\n");
+    }
+
+    if (argc > 1) {
+        int bench_n = atoi(argv[1]);
+        search_benchmark_linear(bench_n, 1000);
+        for (long m = 10000; m <= bench_n; m *= 10) {
+            search_benchmark_sorted(m, 1000000);
+        }
+        search_benchmark_batch(bench_n, 1000000);
+        search_benchmark_learned(bench_n, 100000);
+
+        size_t span_n = argc > 2 ? strtoull(argv[2], NULL, 10) : bench_n;
+        search_benchmark_span<int32_t>(min(span_n, (size_t)1 << 29), 1000000, "int32_t");
+        search_benchmark_span<uint64_t>(span_n, 1000000, "uint64_t");
+        search_benchmark_span<int64_t>(span_n, 1000000, "int64_t");
+#ifdef SEARCH_MMAP
+        search_benchmark_file("search_keys.tmp", span_n, 1000000);
+#endif
+    }
 }
\ No newline at end of file
@@ -8,11 +8,15 @@
 //     Insertion Sort       O(n*n)          O(n)
 //     Selection Sort       O(n*n)          O(n*n)
 //   Advanced Sort Methods
-//     Quick Sort           O(n*n)          O(n*log(n))
+//     Quick Sort           O(n*log(n))     O(n*log(n))     (introsort)
+//     Parallel Quick Sort  O(n*log(n)/p)                   (work-stealing)
 //     Merge Sort           O(n*logn)       O(n*log(n))
+//     K-way Merge Sort     O(n*logn)       O(n*log(n))
 //     Shell Sort           O(n*(logn)^2)
 //     Radix Sort           O(m*(n+r))
 //     Heap Sort            O(n*log(n))     O(n*log(n))
+//   Selection of the n-th element
+//     Intro Select         O(n*log(n))     O(n)
 //     Binary Tree Sort (see tree.cpp)
 //
 //  the following programs sort an arry in asending order.
@@ -21,6 +25,14 @@
 //        from other arguments.
 //
 #include <iostream>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+
+#define HEAP_LIBRARY    // LoserTree without the heap testing driver
+#include "heap.cpp"
 
 using namespace std;
 
@@ -95,41 +107,113 @@ void selection_sort(long *a, int sz)
         swap(a[j], a[low]);
     }
 }
+/* helpers of the introspective quick sorts:
+ *   INSERTION_CUTOFF: a part this short is insertion sorted, no partition.
+ *   intro_depth: the partitions allowed before the heap sort, 2*log2(n).
+ *   heap_sort_part: the fallback when the pivots keep going bad, so the
+ *                   worst case is O(n*log(n)) (see heap.cpp).
+ *   median_pivot: the index of the median of the first, middle and last,
+ *                 the median of three medians (ninther) of 9 elements
+ *                 spread over the part if it is longer than 128.
+ */
+#define INSERTION_CUTOFF    16
+int intro_depth(int n)
+{
+    int depth = 0;
+    for (; n > 1; n >>= 1) { depth += 2; }
+    return depth;
+}
+void heap_sort_part(long a[], int n)
+{
+    heap_make(a, n, greater<long>());
+    for (; n > 1; --n) {
+        heap_pop(a, n, greater<long>());
+    }
+}
+int median_of_three(long a[], int i, int j, int k)
+{
+    if (a[i] < a[j]) {
+        return a[j] < a[k] ? j : (a[i] < a[k] ? k : i);
+    }
+    return a[i] < a[k] ? i : (a[j] < a[k] ? k : j);
+}
+int median_pivot(long a[], int left, int right)
+{
+    int middle = left + ((right - left) >> 1);
+    if (right - left < 128) {
+        return median_of_three(a, left, middle, right);
+    }
+    int d = (right - left) >> 3;
+    return median_of_three(a, median_of_three(a, left, left + d, left + 2 * d),
+                              median_of_three(a, middle - d, middle, middle + d),
+                              median_of_three(a, right - 2 * d, right - d, right));
+}
 /* Quick Sort (Patition Exchange Sort) with single pivot:
  *    invented by C.A.R. Hoare to improve slection sort.
  *    the most efficient internal sorting methods.
  *    uses the hardware cache most effectively.
  * algorithm: one of divide-and-conquer methods
- *    choose the first (left) as the pivot and start from both sides
- *    move the front pointer until find the item greater than the pivot
- *    move the back pointer until find the item less than the pivot
+ *    choose the median (of 3, or the ninther) as the pivot, move it to the
+ *    first (left) and start from both sides
+ *    move the front pointer until find the item not less than the pivot
+ *    move the back pointer until find the item not greater than the pivot
  *    swap the items in the two group (front and back). so
  *    all the items that less than the pivot to the front
  *    all the items that greater than the pivot to the back
- *    swap the first in the front with the first in the back
+ *    the items equal to the pivot stop both pointers, they are split
+ *    evenly, so the many duplicates don't make it quadratic.
+ *    swap the first with the last in the front
  *    recursively to quick-sort on the two groups.
+ * introsort (introspective sort, David Musser 1997):
+ *    insertion sort the short groups (INSERTION_CUTOFF),
+ *    heap sort a group if the partitions go deeper than 2*log2(n),
+ *    recurse on the shorter group, loop on the longer one, so the stack
+ *    is O(log(n)) even on the sorted or reversed arrays.
  * implementations: recursive and iterative
- * time complexity: best O(n*log(n)), worst O(n*n)
- * space complexity: O(1)
+ * time complexity: best O(n*log(n)), worst O(n*log(n))
+ * space complexity: O(log(n))
  */
-void single_pivot_quick_sort(long *a, int left, int right)
+int single_pivot_partition(long *a, int left, int right)
 {
-    if (left >= right) {
-        return;
-    }
+    swap(a[left], a[median_pivot(a, left, right)]);
     long pivot = a[left];
     int i = left;
-    int j = right;
-    while(i < j) {
-        while ((i < right) && (a[i] <= pivot)) { ++i; }
-        while ((j > left) && (a[j] >= pivot)) { --j; }
-        if (i < j) { 
-            swap(a[i], a[j]);
+    int j = right + 1;
+    while (true) {
+        while (a[++i] < pivot) { if (i == right) break; }
+        while (pivot < a[--j]) { }     // stops at a[left] at the latest
+        if (i >= j) {
+            break;
         }
+        swap(a[i], a[j]);
     }
     swap(a[j], a[left]);
-    single_pivot_quick_sort(a, left, j - 1);
-    single_pivot_quick_sort(a, j + 1, right);
+    return j;
+}
+void intro_sort(long *a, int left, int right, int depth)
+{
+    while (right - left >= INSERTION_CUTOFF) {
+        if (depth-- == 0) {
+            heap_sort_part(a + left, right - left + 1);
+            return;
+        }
+        int j = single_pivot_partition(a, left, right);
+        if (j - left < right - j) {
+            intro_sort(a, left, j - 1, depth);
+            left = j + 1;
+        }
+        else {
+            intro_sort(a, j + 1, right, depth);
+            right = j - 1;
+        }
+    }
+    if (left < right) {
+        insertion_sort(a + left, right - left + 1);
+    }
+}
+void single_pivot_quick_sort(long *a, int left, int right)
+{
+    intro_sort(a, left, right, intro_depth(right - left + 1));
 }
 /* Dual Pivot Qick Sort
  *   Invented by Vladimir Yaroslavskiy in 2009.
@@ -143,25 +227,64 @@ void single_pivot_quick_sort(long *a, int left, int right)
  *   elements in the middle part are greater than the left pivot
  *   but less than the right pivot.
  * Implementations:
- *   if the array is already sorted, will bring to the worse case.
- *   may choose the median to be the pivots.
+ *   the pivots are the 2nd and 4th of 5 elements spread over the part
+ *   (tertiles, as Java does), not the first and last, so the sorted
+ *   arrays are not the worst case.
+ *   if the two pivots are equal, partition into less than, equal to and
+ *   greater than the pivot, the equal part is done.
+ *   the same introspection as the single pivot quick sort: insertion
+ *   sort the short parts, heap sort after 2*log2(n) partitions.
  * Time Complexity:
  *   the average number of comparisons is 2*n*ln(n),
  *   the average number of swaps is 0.8*n*ln(n).
  *   the single pivot Quicksort has 2*n*ln(n) and 1*n*ln(n) respectively.
- * Space Complexity: O(1)
+ *   worst O(n*log(n)).
+ * Space Complexity: O(log(n))
  */
-void dual_pivot_quick_sort(long *a, int left, int right)
+void dual_pivot_intro_sort(long *a, int left, int right, int depth)
 {
-    if (left >= right)
+    if (right - left < INSERTION_CUTOFF) {
+        if (left < right) {
+            insertion_sort(a + left, right - left + 1);
+        }
         return;
+    }
+    if (depth-- == 0) {
+        heap_sort_part(a + left, right - left + 1);
+        return;
+    }
+    // sort 5 elements at the sevenths, the 2nd and 4th are the pivots
+    int d = (right - left + 1) / 7;
+    int middle = left + ((right - left) >> 1);
+    int e[5] = { middle - 2 * d, middle - d, middle, middle + d, middle + 2 * d };
+    for (int i = 1; i < 5; ++i) {
+        for (int k = i; k > 0 && a[e[k]] < a[e[k - 1]]; --k) {
+            swap(a[e[k]], a[e[k - 1]]);
+        }
+    }
+    swap(a[left], a[e[1]]);
+    swap(a[right], a[e[3]]);
+    long p = a[left];   // the left pivot
+    long q = a[right];  // the right pivot
 
-    // the left pivot should be less than the right pivot
-    if (a[left] > a[right]) {
-        swap(a[left], a[right]);
+    if (p == q) {
+        // [left, lt) < p, [lt, gt] == p, (gt, right] > p
+        int lt = left, gt = right;
+        for (int i = left; i <= gt; ) {
+            if (a[i] < p) {
+                swap(a[lt++], a[i++]);
+            }
+            else if (a[i] > p) {
+                swap(a[i], a[gt--]);
+            }
+            else {
+                ++i;
+            }
+        }
+        dual_pivot_intro_sort(a, left, lt - 1, depth);
+        dual_pivot_intro_sort(a, gt + 1, right, depth);
+        return;
     }
-    int p = a[left];    // the left pivot
-    int q = a[right];   // the right pivot
     int j = left + 1;   // iterator of the left partition
     int g = right - 1;  // iterator of the right partition
 
@@ -189,9 +312,173 @@ void dual_pivot_quick_sort(long *a, int left, int right)
     swap(a[left], a[--j]); 
     swap(a[right], a[++g]); 
   
-    dual_pivot_quick_sort(a, left,  j - 1);
-    dual_pivot_quick_sort(a, j + 1, g - 1);
-    dual_pivot_quick_sort(a, g + 1, right);
+    dual_pivot_intro_sort(a, left,  j - 1, depth);
+    dual_pivot_intro_sort(a, j + 1, g - 1, depth);
+    dual_pivot_intro_sort(a, g + 1, right, depth);
+}
+void dual_pivot_quick_sort(long *a, int left, int right)
+{
+    dual_pivot_intro_sort(a, left, right, intro_depth(right - left + 1));
+}
+/* Parallel Quick Sort
+ *   the single pivot introsort on a work-stealing thread pool.
+ * algorithm:
+ *   every worker (thread) has a deque of tasks (parts of the array),
+ *   a worker partitions its part, pushes one group onto the back of its
+ *   deque and goes on with the other, until the part is not longer than
+ *   SORT_PARALLEL_CUTOFF, then introsorts it alone.
+ *   a worker takes its next task from the back of its own deque (the
+ *   last pushed, still in its cache), an idle worker steals from the
+ *   front of the other deques (the oldest, the longest parts).
+ *   pending counts the tasks not finished yet, the workers stop at 0.
+ * time complexity: O(n*log(n)/p) with p threads, the first partitions
+ *   of the whole array are not parallel, O(n) of them.
+ * space complexity: O(log(n)) per thread
+ */
+#define SORT_PARALLEL_CUTOFF    8192
+struct SortTask {
+    int left, right, depth;
+};
+struct SortWorker {
+    mutex lock;
+    deque<SortTask> tasks;
+};
+struct SortPool {
+    long *a;
+    vector<SortWorker> workers;
+    atomic<int> pending;
+
+    SortPool(long *a, int threads) : a(a), workers(threads), pending(0) { }
+
+    void push(int w, const SortTask& t) {
+        pending.fetch_add(1);
+        lock_guard<mutex> guard(workers[w].lock);
+        workers[w].tasks.push_back(t);
+    }
+    bool pop(int w, SortTask& t) {
+        lock_guard<mutex> guard(workers[w].lock);
+        if (workers[w].tasks.empty()) {
+            return false;
+        }
+        t = workers[w].tasks.back();
+        workers[w].tasks.pop_back();
+        return true;
+    }
+    bool steal(int w, SortTask& t) {
+        int n = workers.size();
+        for (int i = 1; i < n; ++i) {
+            SortWorker& victim = workers[(w + i) % n];
+            lock_guard<mutex> guard(victim.lock);
+            if (!victim.tasks.empty()) {
+                t = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+    void sort(int w, SortTask t) {
+        while (t.right - t.left >= SORT_PARALLEL_CUTOFF && t.depth > 0) {
+            --t.depth;
+            int j = single_pivot_partition(a, t.left, t.right);
+            push(w, SortTask{ t.left, j - 1, t.depth });
+            t.left = j + 1;
+        }
+        intro_sort(a, t.left, t.right, t.depth);
+    }
+    void run(int w) {
+        SortTask t;
+        while (pending.load() > 0) {
+            if (pop(w, t) || steal(w, t)) {
+                sort(w, t);
+                pending.fetch_sub(1);
+            }
+            else {
+                this_thread::yield();
+            }
+        }
+    }
+};
+void parallel_quick_sort(long a[], int sz, int threads = 0)
+{
+    if (threads <= 0) {
+        threads = max(1u, thread::hardware_concurrency());
+    }
+    if (threads == 1 || sz <= SORT_PARALLEL_CUTOFF) {
+        single_pivot_quick_sort(a, 0, sz - 1);
+        return;
+    }
+    SortPool pool(a, threads);
+    pool.push(0, SortTask{ 0, sz - 1, intro_depth(sz) });
+    vector<thread> workers;
+    for (int w = 1; w < threads; ++w) {
+        workers.emplace_back(&SortPool::run, &pool, w);
+    }
+    pool.run(0);
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+/* Intro Select (Quick Select)
+ *   find the n-th smallest element of an array without sorting it,
+ *   e.g. the median, or the k smallest (or largest) elements.
+ *   the same as nth_element of the C++ standard library.
+ * algorithm:
+ *   partition the array as the quick sort, by the median of three pivot
+ *   (the ninther if the part is longer than 128),
+ *   into three parts: less than, equal to and greater than the pivot,
+ *   only go on with the part which has the n-th element.
+ *   stop when the n-th element is in the equal part,
+ *   insertion sort a short part (16 elements or less),
+ *   heap sort the part when the partitions go too deep (2*log2(n)),
+ *   so the worst case is O(n*log(n)) instead of O(n*n).
+ * output:
+ *   a[nth] is the element in the sorted order, the elements before it
+ *   are not greater, the elements after it are not less.
+ * time complexity: average O(n), worst O(n*log(n))
+ * space complexity: O(1)
+ */
+void intro_select(long a[], int sz, int nth)
+{
+    if (nth < 0 || nth >= sz) {
+        return;
+    }
+    int left = 0;
+    int right = sz - 1;
+    int depth = intro_depth(sz);
+
+    while (right - left > INSERTION_CUTOFF) {
+        if (depth-- == 0) {     // heap sort the part (see heap.cpp)
+            heap_sort_part(a + left, right - left + 1);
+            return;
+        }
+        // the median of three, or the ninther
+        long pivot = a[median_pivot(a, left, right)];
+
+        // [left, lt) < pivot, [lt, gt] == pivot, (gt, right] > pivot
+        int lt = left, gt = right;
+        for (int i = left; i <= gt; ) {
+            if (a[i] < pivot) {
+                swap(a[lt++], a[i++]);
+            }
+            else if (a[i] > pivot) {
+                swap(a[i], a[gt--]);
+            }
+            else {
+                ++i;
+            }
+        }
+        if (nth < lt) {
+            right = lt - 1;
+        }
+        else if (nth > gt) {
+            left = gt + 1;
+        }
+        else {
+            return;
+        }
+    }
+    insertion_sort(a + left, right - left + 1);
 }
 /* Merge Sort
  *    efficient for external sorting, such as, data in a file.
@@ -261,6 +548,42 @@ void merge_sort_recursive(long a[], int left, int right)
     merge_sort_recursive(a, middle + 1, right); 
     merge_sort(a, left, middle, right); 
 } 
+/* K-way Merge Sort
+ *    merge k sorted runs at a time instead of two, the number of passes
+ *    over the data is log_k(n), it is how the external sorting merges
+ *    hundreds of runs from the disk.
+ * algorithm: bottom-up
+ *    sort the short runs (MERGE_RUN elements) by insertion sort,
+ *    merge every MERGE_WAYS runs into one by a loser tree (see heap.cpp),
+ *    into a buffer, then swap the array and the buffer,
+ *    repeat until only one run is left.
+ * time complexity: O(nlogn), log2(k) comparisons per element per pass
+ * space complexity: O(n)
+ */
+#define MERGE_RUN   32
+#define MERGE_WAYS  16
+void merge_sort_kway(long a[], int sz)
+{
+    for (int i = 0; i < sz; i += MERGE_RUN) {
+        insertion_sort(a + i, min(MERGE_RUN, sz - i));
+    }
+
+    vector<long> buffer(sz);
+    long *src = a, *dst = buffer.data();
+    for (long run = MERGE_RUN; run < sz; run *= MERGE_WAYS) {
+        for (long i = 0; i < sz; i += run * MERGE_WAYS) {
+            vector<pair<long*, long*>> runs;
+            for (long j = i; j < min((long)sz, i + run * MERGE_WAYS); j += run) {
+                runs.push_back(make_pair(src + j, src + min((long)sz, j + run)));
+            }
+            loser_tree_merge(runs, dst + i);
+        }
+        swap(src, dst);
+    }
+    if (src != a) {
+        copy(src, src + sz, a);
+    }
+}
 /* Shell Sort Half
  *    always split the array into half (virtually)
  *    a special case of the Shell Sort
@@ -354,6 +677,7 @@ void radix_sort(long a[], int first, int last, int bitnum)
 #include <chrono>
 #include <functional>
 #include <cmath>
+#include <algorithm>
 
 void sort_display(long a[], int n)
 {
@@ -388,7 +712,41 @@ void sort_function(long a[], int n, function<void (long*, int, int, int)> f) { f
     sort_display(A, n); \
 }
 
-int main()
+/* sort_benchmark:
+ *   the quick sorts on n random, sorted, reversed and equal keys, the
+ *   sorted and equal keys were the worst (quadratic) cases of the first
+ *   (left) pivot, std::sort (introsort) for reference.
+ */
+void sort_benchmark(int n)
+{
+    vector<long> input(n), v(n);
+    int threads = max(2u, thread::hardware_concurrency());
+    const char *orders[] = { "random", "sorted", "reversed", "equal" };
+    for (int order = 0; order < 4; ++order) {
+        for (int i = 0; i < n; ++i) {
+            input[i] = order == 0 ? rand() : order == 1 ? i : order == 2 ? n - i : 7;
+        }
+        cout << "---- sort " << n << " " << orders[order] << " keys ----" << endl;
+#define TESTING_SORT_BENCH(s, ...) { \
+        v = input; \
+        cout << "\e[1m" << s << "\e[0m" << ": "; \
+        auto start = chrono::high_resolution_clock::now(); \
+        __VA_ARGS__; \
+        auto end = chrono::high_resolution_clock::now(); \
+        cout << "Elapsed time " << chrono::duration_cast<chrono::microseconds>(end - start).count() << " us" \
+             << (is_sorted(v.begin(), v.end()) ? "" : ", not sorted") << endl; \
+}
+        TESTING_SORT_BENCH("Quick Sort              ", single_pivot_quick_sort(v.data(), 0, n - 1));
+        TESTING_SORT_BENCH("Dual Pivot Quick Sort   ", dual_pivot_quick_sort(v.data(), 0, n - 1));
+        TESTING_SORT_BENCH("Parallel Quick Sort (" + to_string(threads) + ")", parallel_quick_sort(v.data(), n, threads));
+        TESTING_SORT_BENCH("C++ sort                ", sort(v.begin(), v.end()));
+#undef TESTING_SORT_BENCH
+    }
+}
+/* testing main
+ *   could take the size of the arrays to run the benchmarks.
+ */
+int main(int argc, char *argv[])
 {
     int n = 10000;
     long A[n];
@@ -408,8 +766,12 @@ int main()
 
     TESTING_SORT("Dual Pivot Quick Sort", dual_pivot_quick_sort);
 
+    TESTING_SORT("Parallel Quick Sort", [](long *a, int sz) { parallel_quick_sort(a, sz); });
+
     TESTING_SORT("Merge Sort", merge_sort_recursive);
 
+    TESTING_SORT("K-way Merge Sort", merge_sort_kway);
+
     TESTING_SORT("Shell Half", shell_half_sort);
 
     TESTING_SORT("Shell Sort", shell_sort);
@@ -417,5 +779,19 @@ int main()
     TESTING_SORT("Radix Sort", radix_sort);
 
     cout << "Heap Sort: see \"heap.cpp\"" << endl << endl;
+
+    {
+        cout << "\e[1m" << "Intro Select (median)" << "\e[0m" << ": ";
+        copy(B, B + n, A);
+        auto start = chrono::high_resolution_clock::now();
+        intro_select(A, n, n / 2);
+        auto end = chrono::high_resolution_clock::now();
+        cout << "Elapsed time " << chrono::duration_cast<chrono::microseconds>(end - start).count() << " us " << endl;
+        cout << "A[" << n / 2 << "] = " << A[n / 2] << endl << endl;
+    }
+
+    if (argc > 1) {
+        sort_benchmark(atoi(argv[1]));
+    }
 } 
 